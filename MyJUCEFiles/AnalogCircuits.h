@@ -1 +1,800 @@
-#include "../../fxobjects/fxobjects.h"
\ No newline at end of file
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace magna {
+
+	/* The kernels below are written once against a "lane" type, which is either a plain double or float (one channel) or a
+	juce::dsp::SIMDRegister of either (one channel per element), so the same code runs a single channel or several in lockstep, in double
+	or single precision. toFloats() and fromFloats() narrow a lane to float storage and back */
+	template <typename Lane>
+	struct LaneTraits {
+		using Element = Lane;
+		static constexpr int size = 1;
+		static Lane expand(double value) noexcept { return (Lane)value; }
+		static void toFloats(Lane value, float* destination) noexcept { destination[0] = (float)value; }
+		static Lane fromFloats(const float* source) noexcept { return (Lane)source[0]; }
+		template <typename Function>
+		static Lane map(Lane value, Function&& function) noexcept { return function(value); }
+	};
+
+	template <typename ElementType>
+	struct LaneTraits<juce::dsp::SIMDRegister<ElementType>> {
+		using Element = ElementType;
+		using SIMD = juce::dsp::SIMDRegister<Element>;
+		static constexpr int size = (int)SIMD::SIMDNumElements;
+		static SIMD expand(double value) noexcept { return SIMD::expand((Element)value); }
+
+		static void toFloats(SIMD value, float* destination) noexcept {
+			alignas(SIMD::SIMDRegisterSize) Element elements[size];
+			value.copyToRawArray(elements);
+			for (int i = 0; i < size; ++i)
+				destination[i] = (float)elements[i];
+		}
+
+		static SIMD fromFloats(const float* source) noexcept {
+			alignas(SIMD::SIMDRegisterSize) Element elements[size];
+			for (int i = 0; i < size; ++i)
+				elements[i] = (Element)source[i];
+			return SIMD::fromRawArray(elements);
+		}
+
+		/* for what SIMDRegister can't do, like exp and log: function(Element) on each element in turn */
+		template <typename Function>
+		static SIMD map(SIMD value, Function&& function) noexcept {
+			alignas(SIMD::SIMDRegisterSize) Element elements[size];
+			value.copyToRawArray(elements);
+			for (int i = 0; i < size; ++i)
+				elements[i] = function(elements[i]);
+			return SIMD::fromRawArray(elements);
+		}
+	};
+
+	/* WAVE DIGITAL FILTER TEMPLATES */
+
+	/* A WDF tree is a type: leaves (Resistor, Capacitor, Inductor, ResistiveVoltageSource) nested in 3-port Series and Parallel adaptors,
+	held by value, under a root. Nothing is virtual or linked by pointers, so a root's process() inlines into one straight-line kernel:
+	reflected() gathers the waves up the tree, accept() scatters them back down and stores the new state.
+	Component values are set on the leaves at runtime; update(sampleRate) then recomputes the port resistances and adaptor coefficients
+	bottom-up (call it on the root after any change). The coefficients can also be read out and written back as a flat array
+	(numCoefficients of them, in a fixed order), which is what CutoffTable caches and interpolates.
+	Leaves that reflect nothing (adapted resistors) say so at compile time, and the adaptors above them drop the terms instead of adding zeros.
+	Every node is templated on the lane type, so a tree of juce::dsp::SIMDRegister runs one circuit per lane. The reactive leaves also take
+	the storage for their state, which is what a Precision (below) picks */
+	namespace wdf {
+
+		template <typename Lane>
+		inline Lane zero() noexcept { return LaneTraits<Lane>::expand(0.0); }
+
+		/* state kept between samples at the lane's own precision */
+		template <typename Lane>
+		struct LaneState {
+			Lane value = zero<Lane>();
+			Lane load() const noexcept { return value; }
+			void store(Lane newValue) noexcept { value = newValue; }
+		};
+
+		/* state kept between samples as float, whatever the lane computes in */
+		template <typename Lane>
+		struct FloatState {
+			float values[LaneTraits<Lane>::size] = {};
+			Lane load() const noexcept { return LaneTraits<Lane>::fromFloats(values); }
+			void store(Lane newValue) noexcept { LaneTraits<Lane>::toFloats(newValue, values); }
+		};
+
+		/* What a filter computes in (Element) and how its reactive leaves keep their state (State). Coefficients are always designed and
+		tabulated in double, then rounded to Element.
+		- DoublePrecision: the reference
+		- SinglePrecision: float throughout, so a SIMD register holds twice the channels
+		- MixedPrecision: float state, double arithmetic, so every sum and product is exact to double and only the stored waves are rounded */
+		struct DoublePrecision {
+			using Element = double;
+			template <typename Lane> using State = LaneState<Lane>;
+		};
+
+		struct SinglePrecision {
+			using Element = float;
+			template <typename Lane> using State = LaneState<Lane>;
+		};
+
+		struct MixedPrecision {
+			using Element = double;
+			template <typename Lane> using State = FloatState<Lane>;
+		};
+
+		template <typename Lane>
+		struct Resistor {
+			static constexpr bool reflectsNothing = true;
+			double resistance = 1.0, portResistance = 1.0;
+			Lane incident = zero<Lane>();
+
+			static constexpr int numCoefficients = 0;
+			double* getCoefficients(double* destination) const noexcept { return destination; }
+			const double* setCoefficients(const double* source) noexcept { return source; }
+
+			void update(double) noexcept { portResistance = resistance; }
+			void reset() noexcept { incident = zero<Lane>(); }
+			Lane reflected() noexcept { return zero<Lane>(); }
+			void accept(Lane a) noexcept { incident = a; }
+			Lane voltage() const noexcept { return incident * LaneTraits<Lane>::expand(0.5); }
+		};
+
+		/* bilinear transform: a port of T/2C that reflects the last incident wave */
+		template <typename Lane, template <typename> class State = LaneState>
+		struct Capacitor {
+			static constexpr bool reflectsNothing = false;
+			double capacitance = 1.0e-6, portResistance = 1.0;
+			State<Lane> state;
+
+			static constexpr int numCoefficients = 0;
+			double* getCoefficients(double* destination) const noexcept { return destination; }
+			const double* setCoefficients(const double* source) noexcept { return source; }
+
+			void update(double sampleRate) noexcept { portResistance = 1.0 / (2.0 * capacitance * sampleRate); }
+			void reset() noexcept { state.store(zero<Lane>()); }
+			Lane reflected() noexcept { return state.load(); }
+			void accept(Lane a) noexcept { state.store(a); }
+		};
+
+		/* bilinear transform: a port of 2L/T that reflects the last incident wave negated */
+		template <typename Lane, template <typename> class State = LaneState>
+		struct Inductor {
+			static constexpr bool reflectsNothing = false;
+			double inductance = 1.0e-3, portResistance = 1.0;
+			State<Lane> state;
+
+			static constexpr int numCoefficients = 0;
+			double* getCoefficients(double* destination) const noexcept { return destination; }
+			const double* setCoefficients(const double* source) noexcept { return source; }
+
+			void update(double sampleRate) noexcept { portResistance = 2.0 * inductance * sampleRate; }
+			void reset() noexcept { state.store(zero<Lane>()); }
+			Lane reflected() noexcept { return state.load(); }
+			void accept(Lane a) noexcept { state.store(zero<Lane>() - a); }
+		};
+
+		/* a voltage source in series with its resistance, as a leaf (for trees rooted at something else, like a nonlinearity) */
+		template <typename Lane>
+		struct ResistiveVoltageSource {
+			static constexpr bool reflectsNothing = false;
+			double resistance = 1.0, portResistance = 1.0;
+			Lane voltage = zero<Lane>(), incident = zero<Lane>();
+
+			static constexpr int numCoefficients = 0;
+			double* getCoefficients(double* destination) const noexcept { return destination; }
+			const double* setCoefficients(const double* source) noexcept { return source; }
+
+			void update(double) noexcept { portResistance = resistance; }
+			void reset() noexcept { incident = zero<Lane>(); }
+			Lane reflected() noexcept { return voltage; }
+			void accept(Lane a) noexcept { incident = a; }
+		};
+
+		/* Series and Parallel skip the waves of children that reflect nothing. The tests are compile-time constants, so the dead branch is
+		dropped without C++17's if constexpr (the projects build as C++14) */
+
+		/* the port towards the root is adapted: R = R_left + R_right */
+		template <typename Lane, typename Left, typename Right>
+		struct Series {
+			static constexpr bool reflectsNothing = false;
+			Left left;
+			Right right;
+			double portResistance = 1.0;
+			Lane leftShare = zero<Lane>(), rightShare = zero<Lane>(); // R_left / R, R_right / R
+			Lane leftWave = zero<Lane>(), rightWave = zero<Lane>(); // what the children reflected this sample
+
+			void update(double sampleRate) noexcept {
+				left.update(sampleRate);
+				right.update(sampleRate);
+				portResistance = left.portResistance + right.portResistance;
+				leftShare = LaneTraits<Lane>::expand(left.portResistance / portResistance);
+				rightShare = LaneTraits<Lane>::expand(right.portResistance / portResistance);
+			}
+
+			static constexpr int numCoefficients = 2 + Left::numCoefficients + Right::numCoefficients;
+
+			/* scalar lanes only */
+			double* getCoefficients(double* destination) const noexcept {
+				*destination++ = leftShare;
+				*destination++ = rightShare;
+				return right.getCoefficients(left.getCoefficients(destination));
+			}
+
+			const double* setCoefficients(const double* source) noexcept {
+				leftShare = LaneTraits<Lane>::expand(*source++);
+				rightShare = LaneTraits<Lane>::expand(*source++);
+				return right.setCoefficients(left.setCoefficients(source));
+			}
+
+			void reset() noexcept {
+				left.reset();
+				right.reset();
+			}
+
+			Lane reflected() noexcept {
+				leftWave = left.reflected();
+				rightWave = right.reflected();
+				if (Left::reflectsNothing)
+					return zero<Lane>() - rightWave;
+				else if (Right::reflectsNothing)
+					return zero<Lane>() - leftWave;
+				else
+					return zero<Lane>() - (leftWave + rightWave);
+			}
+
+			void accept(Lane a) noexcept {
+				Lane sum = a;
+				if (!Left::reflectsNothing)
+					sum = sum + leftWave;
+				if (!Right::reflectsNothing)
+					sum = sum + rightWave;
+
+				if (Left::reflectsNothing)
+					left.accept(zero<Lane>() - leftShare * sum);
+				else
+					left.accept(leftWave - leftShare * sum);
+				if (Right::reflectsNothing)
+					right.accept(zero<Lane>() - rightShare * sum);
+				else
+					right.accept(rightWave - rightShare * sum);
+			}
+		};
+
+		/* the port towards the root is adapted: G = G_left + G_right */
+		template <typename Lane, typename Left, typename Right>
+		struct Parallel {
+			static constexpr bool reflectsNothing = false;
+			Left left;
+			Right right;
+			double portResistance = 1.0;
+			Lane leftShare = zero<Lane>(), rightShare = zero<Lane>(); // G_left / G, G_right / G
+			Lane leftWave = zero<Lane>(), rightWave = zero<Lane>(), upWave = zero<Lane>();
+
+			void update(double sampleRate) noexcept {
+				left.update(sampleRate);
+				right.update(sampleRate);
+				auto leftConductance = 1.0 / left.portResistance, rightConductance = 1.0 / right.portResistance;
+				portResistance = 1.0 / (leftConductance + rightConductance);
+				leftShare = LaneTraits<Lane>::expand(leftConductance * portResistance);
+				rightShare = LaneTraits<Lane>::expand(rightConductance * portResistance);
+			}
+
+			static constexpr int numCoefficients = 2 + Left::numCoefficients + Right::numCoefficients;
+
+			/* scalar lanes only */
+			double* getCoefficients(double* destination) const noexcept {
+				*destination++ = leftShare;
+				*destination++ = rightShare;
+				return right.getCoefficients(left.getCoefficients(destination));
+			}
+
+			const double* setCoefficients(const double* source) noexcept {
+				leftShare = LaneTraits<Lane>::expand(*source++);
+				rightShare = LaneTraits<Lane>::expand(*source++);
+				return right.setCoefficients(left.setCoefficients(source));
+			}
+
+			void reset() noexcept {
+				left.reset();
+				right.reset();
+			}
+
+			Lane reflected() noexcept {
+				leftWave = left.reflected();
+				rightWave = right.reflected();
+				if (Left::reflectsNothing)
+					upWave = rightShare * rightWave;
+				else if (Right::reflectsNothing)
+					upWave = leftShare * leftWave;
+				else
+					upWave = leftShare * leftWave + rightShare * rightWave;
+				return upWave;
+			}
+
+			/* every port sees the same voltage; junction is twice it */
+			void accept(Lane a) noexcept {
+				auto junction = a + upWave;
+				if (Left::reflectsNothing)
+					left.accept(junction);
+				else
+					left.accept(junction - leftWave);
+				if (Right::reflectsNothing)
+					right.accept(junction);
+				else
+					right.accept(junction - rightWave);
+			}
+		};
+
+		/* root: a voltage source in series with sourceResistance, driving the tree */
+		template <typename Lane, typename Tree>
+		struct ResistiveSourceRoot {
+			Tree tree;
+			double sourceResistance = 1.0;
+			Lane reflection = zero<Lane>(), gain = zero<Lane>();
+
+			void update(double sampleRate) noexcept {
+				tree.update(sampleRate);
+				auto R = tree.portResistance;
+				reflection = LaneTraits<Lane>::expand((sourceResistance - R) / (sourceResistance + R));
+				gain = LaneTraits<Lane>::expand(2.0 * R / (sourceResistance + R));
+			}
+
+			static constexpr int numCoefficients = 2 + Tree::numCoefficients;
+
+			/* scalar lanes only */
+			double* getCoefficients(double* destination) const noexcept {
+				*destination++ = reflection;
+				*destination++ = gain;
+				return tree.getCoefficients(destination);
+			}
+
+			const double* setCoefficients(const double* source) noexcept {
+				reflection = LaneTraits<Lane>::expand(*source++);
+				gain = LaneTraits<Lane>::expand(*source++);
+				return tree.setCoefficients(source);
+			}
+
+			void reset() noexcept { tree.reset(); }
+
+			void process(Lane voltage) noexcept {
+				tree.accept(reflection * tree.reflected() + gain * voltage);
+			}
+		};
+
+		/* Wright omega, the w that solves w + log(w) = x: D'Angelo's omega4, a cubic fit refined by one Newton step */
+		template <typename Element>
+		inline Element wrightOmega(Element x) noexcept {
+			constexpr auto x1 = (Element)-3.341459552768620, x2 = (Element)8.0;
+			constexpr auto a = (Element)-1.314293149877800e-3, b = (Element)4.775931364975583e-2,
+				c = (Element)3.631952663804445e-1, d = (Element)6.313183464296682e-1;
+
+			Element y;
+			if (x < x1)
+				y = (Element)0;
+			else if (x < x2)
+				y = d + x * (c + x * (b + x * a));
+			else
+				y = x - std::log(x);
+			return y - (y - std::exp(x - y)) / (y + (Element)1);
+		}
+
+		/* root: two antiparallel diodes (Shockley, saturationCurrent and ideality * thermal voltage, a 1N4148 by default), driven by the
+		tree, which holds the circuit's sources as leaves. Only the diode that the incident wave forward-biases is solved, in closed form
+		with Wright omega (Werner et al., "An Improved and Generalized Diode Clipper Model for Wave Digital Filters"), so there is no
+		iteration and the cost per sample is fixed; omega4 keeps the reflected wave within a few mV of the exact solution. The exp and log
+		run element by element on SIMD lanes */
+		template <typename Lane, typename Tree>
+		struct DiodePairRoot {
+			Tree tree;
+			double saturationCurrent = 2.52e-9, thermalVoltage = 1.752 * 25.85e-3;
+			double RIs = 0.0, omegaOffset = 0.0; // port resistance * Is, log(R * Is / Vt) + R * Is / Vt
+
+			void update(double sampleRate) noexcept {
+				tree.update(sampleRate);
+				setRIs(tree.portResistance * saturationCurrent);
+			}
+
+			static constexpr int numCoefficients = 1 + Tree::numCoefficients;
+
+			double* getCoefficients(double* destination) const noexcept {
+				*destination++ = RIs;
+				return tree.getCoefficients(destination);
+			}
+
+			const double* setCoefficients(const double* source) noexcept {
+				setRIs(*source++);
+				return tree.setCoefficients(source);
+			}
+
+			void reset() noexcept { tree.reset(); }
+
+			void process() noexcept {
+				using Element = typename LaneTraits<Lane>::Element;
+				auto Vt = (Element)thermalVoltage, R_Is = (Element)RIs, offset = (Element)omegaOffset;
+
+				tree.accept(LaneTraits<Lane>::map(tree.reflected(), [=](Element a) {
+					auto lambda = a < (Element)0 ? (Element)-1 : (Element)1;
+					return a + (Element)2 * lambda * (R_Is - Vt * wrightOmega(offset + lambda * a / Vt));
+				}));
+			}
+
+		private:
+			void setRIs(double newRIs) noexcept {
+				RIs = newRIs;
+				omegaOffset = std::log(RIs / thermalVoltage) + RIs / thermalVoltage;
+			}
+		};
+
+		/* A circuit's coefficient arrays precomputed over a log-spaced range of cutoffs, so a moving cutoff costs a lookup and a linear
+		interpolation instead of recomputing every component and port resistance. Interpolating keeps each adaptor's shares summing to 1,
+		so the result is always a passive circuit, just one with component values slightly off the exact design between entries */
+		template <int numCoefficients>
+		class CutoffTable {
+		public:
+			/* compute(fc, double* coefficients) fills one entry. Allocates */
+			template <typename Compute>
+			void prepare(double newMinFc, double newMaxFc, int newNumEntries, Compute&& compute) {
+				minFc = newMinFc;
+				numEntries = juce::jmax(2, newNumEntries);
+				entriesPerOctave = (double)(numEntries - 1) / std::log2(newMaxFc / minFc);
+				entries.resize((size_t)(numEntries * numCoefficients));
+				for (int i = 0; i < numEntries; ++i)
+					compute(minFc * std::exp2((double)i / entriesPerOctave), entries.data() + i * numCoefficients);
+			}
+
+			/* fc is clamped to the table's range */
+			void lookup(double fc, double* destination) const noexcept {
+				auto position = juce::jlimit(0.0, (double)(numEntries - 1), std::log2(fc / minFc) * entriesPerOctave);
+				auto index = juce::jmin((int)position, numEntries - 2);
+				auto fraction = position - (double)index;
+				const auto* below = entries.data() + index * numCoefficients;
+				const auto* above = below + numCoefficients;
+				for (int i = 0; i < numCoefficients; ++i)
+					destination[i] = below[i] + fraction * (above[i] - below[i]);
+			}
+
+		private:
+			double minFc = 10.0, entriesPerOctave = 1.0;
+			int numEntries = 0;
+			std::vector<double> entries; // numEntries * numCoefficients
+		};
+
+	}
+
+	/* BUTTERWORTH LPF3 */
+
+	/* Rs - series L1 - shunt C1 - series L2 - RL, the circuit of fxobjects' WDFTunableButterLPF3, as a wdf:: tree rooted at the source.
+	process() returns the voltage across RL (so the passband gain is 0.5). State is the storage of L1, C1 and L2 (see wdf::MixedPrecision) */
+	template <typename Lane, template <typename> class State = wdf::LaneState>
+	struct ButterLPF3Circuit {
+		static constexpr double sourceResistance = 600.0, loadResistance = 600.0;
+		static constexpr double L1_norm = 95.493, C1_norm = 530.516e-6, L2_norm = 95.493; // component values * fc
+
+		using Inductor = wdf::Inductor<Lane, State>;
+		using Capacitor = wdf::Capacitor<Lane, State>;
+		using Tree = wdf::Series<Lane, Inductor,
+					 wdf::Parallel<Lane, Capacitor,
+					 wdf::Series<Lane, Inductor, wdf::Resistor<Lane>>>>;
+		wdf::ResistiveSourceRoot<Lane, Tree> root;
+
+		ButterLPF3Circuit() noexcept {
+			root.sourceResistance = sourceResistance;
+			RL().resistance = loadResistance;
+		}
+
+		Inductor& L1() noexcept { return root.tree.left; }
+		Capacitor& C1() noexcept { return root.tree.right.left; }
+		Inductor& L2() noexcept { return root.tree.right.right.left; }
+		wdf::Resistor<Lane>& RL() noexcept { return root.tree.right.right.right; }
+
+		/* in henries and farads */
+		void setComponents(double l1, double c1, double l2, double sampleRate) noexcept {
+			L1().inductance = l1;
+			C1().capacitance = c1;
+			L2().inductance = l2;
+			root.update(sampleRate);
+		}
+
+		/* usePostWarping pre-warps fc so the bilinear transform puts the -3dB point exactly at fc */
+		void setCutoff(double fc, double sampleRate, bool usePostWarping) noexcept {
+			fc = designCutoff(fc, sampleRate, usePostWarping);
+			setComponents(L1_norm / fc, C1_norm / fc, L2_norm / fc, sampleRate);
+		}
+
+		static double designCutoff(double fc, double sampleRate, bool usePostWarping) noexcept {
+			fc = juce::jlimit(1.0, 0.49 * sampleRate, fc);
+			if (usePostWarping) {
+				auto arg = juce::MathConstants<double>::pi * fc / sampleRate;
+				fc *= std::tan(arg) / arg;
+			}
+			return fc;
+		}
+
+		static constexpr int numCoefficients = decltype(root)::numCoefficients;
+		double* getCoefficients(double* destination) const noexcept { return root.getCoefficients(destination); }
+		void setCoefficients(const double* source) noexcept { root.setCoefficients(source); }
+
+		void reset() noexcept { root.reset(); }
+
+		Lane process(Lane x) noexcept {
+			root.process(x);
+			return RL().voltage();
+		}
+	};
+
+	/* ButterLPF3Circuit with an antiparallel diode pair across C1, which soft-clips the voltage there (around +-0.5V: a full-scale input is
+	1V, so the passband is clean up to about -12dBFS). The diodes are the root, with the source as a leaf of the tree:
+	Vs+Rs - series L1 - node - { shunt C1, series L2 - RL } */
+	template <typename Lane, template <typename> class State = wdf::LaneState>
+	struct SaturatingLPF3Circuit {
+		using Design = ButterLPF3Circuit<double>;
+		using Inductor = wdf::Inductor<Lane, State>;
+		using Capacitor = wdf::Capacitor<Lane, State>;
+		using Tree = wdf::Parallel<Lane, wdf::Series<Lane, wdf::ResistiveVoltageSource<Lane>, Inductor>,
+					 wdf::Parallel<Lane, Capacitor,
+					 wdf::Series<Lane, Inductor, wdf::Resistor<Lane>>>>;
+		wdf::DiodePairRoot<Lane, Tree> root;
+
+		SaturatingLPF3Circuit() noexcept {
+			Vs().resistance = Design::sourceResistance;
+			RL().resistance = Design::loadResistance;
+		}
+
+		wdf::ResistiveVoltageSource<Lane>& Vs() noexcept { return root.tree.left.left; }
+		Inductor& L1() noexcept { return root.tree.left.right; }
+		Capacitor& C1() noexcept { return root.tree.right.left; }
+		Inductor& L2() noexcept { return root.tree.right.right.left; }
+		wdf::Resistor<Lane>& RL() noexcept { return root.tree.right.right.right; }
+
+		void setComponents(double l1, double c1, double l2, double sampleRate) noexcept {
+			L1().inductance = l1;
+			C1().capacitance = c1;
+			L2().inductance = l2;
+			root.update(sampleRate);
+		}
+
+		void setCutoff(double fc, double sampleRate, bool usePostWarping) noexcept {
+			fc = Design::designCutoff(fc, sampleRate, usePostWarping);
+			setComponents(Design::L1_norm / fc, Design::C1_norm / fc, Design::L2_norm / fc, sampleRate);
+		}
+
+		static constexpr int numCoefficients = decltype(root)::numCoefficients;
+		double* getCoefficients(double* destination) const noexcept { return root.getCoefficients(destination); }
+		void setCoefficients(const double* source) noexcept { root.setCoefficients(source); }
+
+		void reset() noexcept { root.reset(); }
+
+		Lane process(Lane x) noexcept {
+			Vs().voltage = x;
+			root.process();
+			return RL().voltage();
+		}
+	};
+
+	/* A WDF circuit (ButterLPF3Circuit, SaturatingLPF3Circuit: anything with setCutoff() and the coefficient array) with its own state for
+	every channel. Channels are processed in groups of one juce::dsp::SIMDRegister of the Precision's element (2 channels of double or 4 of float on SSE and NEON), each group interleaved into an aligned scratch block and run
+	through its Circuit in lockstep. Buffers of float or double are filtered in place, whatever the Precision.
+	The cutoff glides (exponentially, over smoothingSeconds) to each new setFilterFc() target. While it moves, the coefficients are looked up
+	every controlInterval samples in a wdf::CutoffTable built in prepare(), so modulation is free of zipper noise and costs an interpolation,
+	not a redesign of the circuit.
+	Tests/WDFPrecision reports how far the single and mixed precision variants are from the double one */
+	template <template <typename, template <typename> class> class CircuitType, typename Precision = wdf::DoublePrecision>
+	class TunableCircuit {
+	public:
+		static constexpr int controlInterval = 16;
+		static constexpr double smoothingSeconds = 0.05;
+		static constexpr double minFc = 10.0;
+		static constexpr int tableSize = 512;
+
+		/* allocates the state, scratch and coefficient table. Call before processing, off the audio thread */
+		void prepare(double newSampleRate, int newNumChannels, int newMaxBlockSize) {
+			sampleRate = newSampleRate;
+			numChannels = juce::jmax(1, newNumChannels);
+			maxBlockSize = juce::jmax(1, newMaxBlockSize);
+			groups.assign((size_t)((numChannels + lanes - 1) / lanes), {});
+			interleaved = juce::dsp::AudioBlock<Element>(interleavedMemory, 1, (size_t)(maxBlockSize * lanes));
+			cutoff.reset(sampleRate, smoothingSeconds);
+			buildTable();
+			reset();
+		}
+
+		/* clears the state and jumps to the target cutoff */
+		void reset() noexcept {
+			for (auto& group : groups)
+				group.reset();
+			cutoff.setCurrentAndTargetValue(cutoff.getTargetValue());
+			applyCutoff(cutoff.getCurrentValue());
+		}
+
+		/* Set it before prepare(), which then builds the table once. Once prepared, a change rebuilds the table, so call it from
+		prepareToPlay() rather than the audio thread */
+		void setUsePostWarping(bool shouldUsePostWarping) {
+			if (shouldUsePostWarping == usePostWarping)
+				return;
+			usePostWarping = shouldUsePostWarping;
+			if (groups.empty())
+				return; // not prepared yet
+			buildTable();
+			applyCutoff(cutoff.getCurrentValue());
+		}
+
+		void setFilterFc(double newFc) noexcept {
+			cutoff.setTargetValue(juce::jlimit(minFc, getMaxFc(), newFc));
+		}
+
+		double getFilterFc() const noexcept { return cutoff.getTargetValue(); }
+
+		/* filters up to the prepared number of channels in place */
+		template <typename SampleType>
+		void process(juce::AudioBuffer<SampleType>& buffer) noexcept {
+			process(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), buffer.getNumSamples());
+		}
+
+		template <typename SampleType>
+		void process(SampleType* const* channelData, int numChannelsToProcess, int numSamples) noexcept {
+			numChannelsToProcess = juce::jmin(numChannelsToProcess, numChannels);
+			for (int start = 0; start < numSamples;) {
+				auto blockSize = juce::jmin(maxBlockSize, numSamples - start);
+				if (cutoff.isSmoothing()) {
+					blockSize = juce::jmin(blockSize, controlInterval);
+					applyCutoff(cutoff.skip(blockSize));
+				}
+
+				for (int firstChannel = 0; firstChannel < numChannelsToProcess; firstChannel += lanes)
+					processGroup(channelData, firstChannel, juce::jmin(lanes, numChannelsToProcess - firstChannel), start, blockSize);
+				start += blockSize;
+			}
+		}
+
+	private:
+		using Element = typename Precision::Element;
+		using SIMD = juce::dsp::SIMDRegister<Element>;
+		using Circuit = CircuitType<SIMD, Precision::template State>;
+		using Design = CircuitType<double, wdf::LaneState>;
+		static constexpr int lanes = LaneTraits<SIMD>::size;
+
+		static constexpr int numCoefficients = Design::numCoefficients;
+
+		double sampleRate = 44100.0;
+		bool usePostWarping = false;
+		int numChannels = 0, maxBlockSize = 0;
+		juce::SmoothedValue<double, juce::ValueSmoothingTypes::Multiplicative> cutoff{ 1000.0 };
+		wdf::CutoffTable<numCoefficients> table;
+
+		std::vector<Circuit> groups;
+		juce::HeapBlock<char> interleavedMemory;
+		juce::dsp::AudioBlock<Element> interleaved; // one channel, SIMD-aligned, maxBlockSize * lanes
+
+		double getMaxFc() const noexcept { return 0.49 * sampleRate; }
+
+		void buildTable() {
+			Design design;
+			table.prepare(minFc, getMaxFc(), tableSize, [&](double fc, double* coefficients) {
+				design.setCutoff(fc, sampleRate, usePostWarping);
+				design.getCoefficients(coefficients);
+			});
+		}
+
+		void applyCutoff(double fc) noexcept {
+			double coefficients[numCoefficients];
+			table.lookup(fc, coefficients);
+			for (auto& group : groups)
+				group.setCoefficients(coefficients);
+		}
+
+		template <typename SampleType>
+		void processGroup(SampleType* const* channelData, int firstChannel, int numGroupChannels, int start, int numSamples) noexcept {
+			auto* data = interleaved.getChannelPointer(0);
+
+			for (int lane = 0; lane < lanes; ++lane) {
+				if (lane < numGroupChannels) {
+					const auto* source = channelData[firstChannel + lane] + start;
+					for (int i = 0; i < numSamples; ++i)
+						data[i * lanes + lane] = (Element)source[i];
+				}
+				else {
+					for (int i = 0; i < numSamples; ++i)
+						data[i * lanes + lane] = (Element)0;
+				}
+			}
+
+			auto circuit = groups[(size_t)(firstChannel / lanes)]; // a local copy lets the compiler keep the state in registers
+			for (int i = 0; i < numSamples; ++i) {
+				auto* frame = data + i * lanes;
+				circuit.process(SIMD::fromRawArray(frame)).copyToRawArray(frame);
+			}
+			groups[(size_t)(firstChannel / lanes)] = circuit;
+
+			for (int lane = 0; lane < numGroupChannels; ++lane) {
+				auto* destination = channelData[firstChannel + lane] + start;
+				for (int i = 0; i < numSamples; ++i)
+					destination[i] = (SampleType)data[i * lanes + lane];
+			}
+		}
+	};
+
+	/* fxobjects' WDFTunableButterLPF3, one state per channel */
+	template <typename Precision = wdf::DoublePrecision>
+	using TunableButterLPF3 = TunableCircuit<ButterLPF3Circuit, Precision>;
+
+	/* the same with diodes across C1; run it oversampled */
+	template <typename Precision = wdf::DoublePrecision>
+	using TunableSaturatingLPF3 = TunableCircuit<SaturatingLPF3Circuit, Precision>;
+
+	/* OVERSAMPLING */
+
+	/* A TunableCircuit (or anything with the same prepare(), reset() and process()) run at 2, 4 or 8 times the host rate between
+	juce::dsp::Oversampling's polyphase IIR half-band filters, so the harmonics a nonlinear circuit makes above the host's Nyquist are
+	filtered out instead of aliasing back. The cost is fixed by the factor (the circuit factor times over, plus the half-band stages),
+	whatever the signal. The latency is rounded to whole samples so it can be reported to the host.
+	The drive gain goes on at the oversampled rate just before the circuit and comes off again just after it, sample by sample, so the
+	two always meet the same samples and a nonlinear circuit only changes how much it distorts, not how loud it is */
+	template <typename Filter>
+	class OversampledFilter {
+	public:
+		/* the drive glides linearly to each new target over this long */
+		static constexpr double driveSmoothingSeconds = 0.05;
+
+		/* factorLog2 is 1, 2 or 3. Allocates, so call it off the audio thread */
+		void prepare(double sampleRate, int newNumChannels, int newMaxBlockSize, int factorLog2) {
+			numChannels = juce::jmax(1, newNumChannels);
+			maxBlockSize = juce::jmax(1, newMaxBlockSize);
+			oversampling = std::make_unique<juce::dsp::Oversampling<float>>((size_t)numChannels, (size_t)juce::jlimit(1, 3, factorLog2),
+				juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, true);
+			oversampling->initProcessing((size_t)maxBlockSize);
+
+			auto factor = (int)oversampling->getOversamplingFactor();
+			filter.prepare(sampleRate * factor, numChannels, maxBlockSize * factor);
+			channelPointers.assign((size_t)numChannels, nullptr);
+			driveGains.allocate((size_t)(maxBlockSize * factor), false);
+			inverseDriveGains.allocate((size_t)(maxBlockSize * factor), false);
+			drive.reset(sampleRate * factor, driveSmoothingSeconds);
+			reset();
+		}
+
+		/* also jumps the drive to its target */
+		void reset() noexcept {
+			if (oversampling != nullptr)
+				oversampling->reset();
+			filter.reset();
+			drive.setCurrentAndTargetValue(drive.getTargetValue());
+		}
+
+		/* to set the cutoff; it runs at the oversampled rate */
+		Filter& getFilter() noexcept { return filter; }
+
+		/* linear gain into the circuit, taken off again after it */
+		void setDrive(float newGain) noexcept { drive.setTargetValue(newGain); }
+
+		int getLatencyInSamples() const noexcept {
+			return oversampling != nullptr ? (int)oversampling->getLatencyInSamples() : 0;
+		}
+
+		/* filters up to the prepared number of channels in place, in pieces no longer than the prepared block size */
+		void process(juce::dsp::AudioBlock<float> block) noexcept {
+			block = block.getSubsetChannelBlock(0, juce::jmin((size_t)numChannels, block.getNumChannels()));
+
+			for (size_t start = 0; start < block.getNumSamples(); start += (size_t)maxBlockSize) {
+				auto subBlock = block.getSubBlock(start, juce::jmin((size_t)maxBlockSize, block.getNumSamples() - start));
+				auto oversampled = oversampling->processSamplesUp(subBlock);
+				auto numSamples = (int)oversampled.getNumSamples();
+
+				for (size_t channel = 0; channel < oversampled.getNumChannels(); ++channel)
+					channelPointers[channel] = oversampled.getChannelPointer(channel);
+
+				if (drive.isSmoothing()) {
+					for (int i = 0; i < numSamples; ++i) {
+						driveGains[i] = drive.getNextValue();
+						inverseDriveGains[i] = 1.0f / driveGains[i];
+					}
+					for (size_t channel = 0; channel < oversampled.getNumChannels(); ++channel)
+						juce::FloatVectorOperations::multiply(channelPointers[channel], driveGains, numSamples);
+					filter.process(channelPointers.data(), (int)oversampled.getNumChannels(), numSamples);
+					for (size_t channel = 0; channel < oversampled.getNumChannels(); ++channel)
+						juce::FloatVectorOperations::multiply(channelPointers[channel], inverseDriveGains, numSamples);
+				}
+				else {
+					auto gain = drive.getTargetValue();
+					if (gain != 1.0f)
+						oversampled.multiplyBy(gain);
+					filter.process(channelPointers.data(), (int)oversampled.getNumChannels(), numSamples);
+					if (gain != 1.0f)
+						oversampled.multiplyBy(1.0f / gain);
+				}
+
+				oversampling->processSamplesDown(subBlock);
+			}
+		}
+
+		void process(juce::AudioBuffer<float>& buffer) noexcept { process(juce::dsp::AudioBlock<float>(buffer)); }
+
+	private:
+		Filter filter;
+		std::unique_ptr<juce::dsp::Oversampling<float>> oversampling;
+		std::vector<float*> channelPointers;
+		juce::SmoothedValue<float> drive{ 1.0f };
+		juce::HeapBlock<float> driveGains, inverseDriveGains;
+		int numChannels = 0, maxBlockSize = 0;
+	};
+
+}
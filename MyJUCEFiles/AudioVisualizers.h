@@ -1,143 +1,834 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "ThreadFunctions.h" // AudioSampleFifo
+#include "SpectrumAnalyser.h"
+#include "MinMaxPyramid.h"
+#include "StereoFieldAnalyser.h"
+#include "LoudnessAnalyser.h"
+#include "FrameGovernor.h"
 
-#define NO_OVERLAY                    0
-#define OVERLAY_INPUTS_AND_OUTPUTS    1
-#define OVERLAY_CHANNELS              2
-#define OVERLAY_ALL                   3
+/* AUDIO FEED VISUALISER */
 
-/* TODO: abandon AudioVisualiserComponent as a base class. Make a virtual base for ChannelInfo, and make a new virtual base class similar to AudioVisualiserComponent:
-           - 4 channel colors, 1 background color; functions setChannelColour() and setBackgroundColour()
-           - keep paint() same as AudioVisualiser. Change paintChannel()
-           - ChannelInfo needs to be different for FFT functioning visualizers
-*/
-
-/* AUDIO VISUALISER */
-
-class AudioVisualiser : public juce::AudioVisualiserComponent {
+/* Base for the views fed from a magna::AudioSampleFifo. It drains the FIFO on a timer whose rate a magna::FrameGovernor adapts, hands the
+   samples to pushSamples() and repaints only when updateVisualiser() says there is something new. It keeps no per-channel data of its own:
+   whatever a view needs (a waveform history, an analyser) lives in the view */
+class AudioFeedVisualiser : public juce::Component, private juce::Timer {
 public:
-
-    AudioVisualiser() : AudioVisualiserComponent(2) {
-        numInputChannels = 2;
-        numOutputChannels = 0;
-        overlayChannels = NO_OVERLAY;
-        backgroundColour = juce::Colours::black;
-        setBufferSize(512);
-        setSamplesPerBlock(256);
+    AudioFeedVisualiser() {
+        setFrameRateRange(10, 60);
     }
 
-    AudioVisualiser(int numInputChannels, int numOutputChannels, std::uint8_t overlayChannels) : 
-            AudioVisualiserComponent(numInputChannels + numOutputChannels), overlayChannels(overlayChannels),
-            numInputChannels(numInputChannels), numOutputChannels(numOutputChannels) 
-    {
-        setBufferSize(512);
-        setSamplesPerBlock(256);
+    ~AudioFeedVisualiser() override {
+        setSource(nullptr);
     }
 
-    ~AudioVisualiser() override {}
+    /* Drains this FIFO on every timer tick instead of having samples pushed from the audio thread. The FIFO must outlive the visualiser
+       or be detached with setSource(nullptr) first. Audio pushed before attaching is thrown away */
+    void setSource(magna::AudioSampleFifo* newSource) {
+        if (source != nullptr)
+            source->setConsumerActive(false);
+
+        source = newSource;
+        if (source != nullptr) {
+            sourceBuffer.setSize(source->getMaxChannels(), 1024);
+            source->discard();
+            source->setConsumerActive(true);
+        }
+    }
 
     void setBackgroundColour(juce::Colour colour) {
         backgroundColour = colour;
+        repaint();
     }
 
-    void setChannelColour(unsigned int channel, juce::Colour colour) {
-        jassert(channel < 4);
+    void setChannelColour(int channel, juce::Colour colour) {
+        jassert(channel >= 0);
         // doesn't check to see if channel is out of range of current channels. Will keep this color saved in case the channel gets added later
-        channelColours[channel] = colour;
+        if ((size_t)channel >= channelColours.size())
+            channelColours.resize((size_t)channel + 1, juce::Colours::transparentBlack);
+        channelColours[(size_t)channel] = colour;
+        channelColourChanged(channel);
     }
 
-    void paint(juce::Graphics& g) override {
-        g.fillAll(backgroundColour);
+    /* colours not set with setChannelColour() cycle through a default palette */
+    juce::Colour getChannelColour(int channel) const {
+        if ((size_t)channel < channelColours.size() && !channelColours[(size_t)channel].isTransparent())
+            return channelColours[(size_t)channel];
+        static const juce::Colour palette[] = { juce::Colours::blue, juce::Colours::red, juce::Colours::purple, juce::Colours::seagreen,
+                                                juce::Colours::orange, juce::Colours::cyan, juce::Colours::yellow, juce::Colours::magenta };
+        return palette[channel % juce::numElementsInArray(palette)];
+    }
 
-        auto r = getLocalBounds().toFloat();
+    /* The timer runs somewhere in {minHz, maxHz}, chosen by a magna::FrameGovernor from the measured update and paint times and how busy the
+       message thread is */
+    void setFrameRateRange(int minHz, int maxHz) {
+        governor.setFrameRateRange(minHz, maxHz);
+        startTimerHz(governor.getFrameRate());
+    }
 
-        switch (overlayChannels) {
-            case NO_OVERLAY: /* every channel gets its own window */
-                paintNoOverlay(g, r);
-                break;
-            case OVERLAY_INPUTS_AND_OUTPUTS: /* inputs are overlayed with each other in a single window , same for outputs */
-                paintOverlayedIO(g, r);
+    const magna::FrameGovernor::Statistics& getRenderStatistics() const noexcept { return governor.getStatistics(); }
+    void resetRenderStatistics() noexcept { governor.resetStatistics(); }
+
+    /* times paintVisualiser() for the governor */
+    void paint(juce::Graphics& g) final {
+        auto start = juce::Time::getMillisecondCounterHiRes();
+        paintVisualiser(g);
+        governor.paintFinished(juce::Time::getMillisecondCounterHiRes() - start);
+    }
+
+protected:
+    juce::Colour backgroundColour = juce::Colours::black;
+
+    /* brings the view's own state up to date on the timer, after the new samples went to pushSamples(). Returns true if a repaint is needed */
+    virtual bool updateVisualiser() = 0;
+
+    virtual void paintVisualiser(juce::Graphics& g) = 0;
+
+    /* where samples drained from the source go, channel count as the source last pushed */
+    virtual void pushSamples(const float** channelData, int numChannels, int numSamples) = 0;
+
+    /* the source's channel count changed, also when it is first known. Called on the message thread before those samples are pushed */
+    virtual void sourceChannelsChanged(int /*numChannels*/) {}
+
+    virtual void channelColourChanged(int /*channel*/) {
+        repaint();
+    }
+
+private:
+    magna::AudioSampleFifo* source = nullptr;
+    juce::AudioBuffer<float> sourceBuffer;
+    int numSourceChannels = 0;
+    magna::FrameGovernor governor;
+    std::vector<juce::Colour> channelColours; // transparent = use the default palette
+
+    /* drains the source, then lets updateVisualiser() decide whether there's a new frame to paint. Ticks with nothing new skip the repaint */
+    void timerCallback() final {
+        governor.beginTick();
+        drainSource();
+        auto changed = updateVisualiser();
+        if (changed)
+            repaint();
+        if (governor.endTick(changed))
+            startTimerHz(governor.getFrameRate());
+    }
+
+    void drainSource() {
+        if (source == nullptr)
+            return;
+
+        // the channel count follows the producer, but only ever changes here on the message thread
+        auto numChannels = source->getNumChannels();
+        if (numChannels > 0 && numChannels != numSourceChannels) {
+            numSourceChannels = numChannels;
+            sourceChannelsChanged(numChannels);
+        }
+
+        for (int numRead = source->pop(sourceBuffer); numRead > 0; numRead = source->pop(sourceBuffer))
+            pushSamples(sourceBuffer.getArrayOfReadPointers(), juce::jmin(numChannels, sourceBuffer.getNumChannels()), numRead);
+    }
+};
+
+/* AUDIO VISUALISER */
+
+/* Scrolling waveform: min/max columns from a magna::MinMaxPyramid, drawn incrementally into cached strip images, one per channel */
+class AudioVisualiser : public AudioFeedVisualiser {
+public:
+    /* Channels are drawn in lanes stacked top to bottom; every lane lists the channels overlayed in it. Channels that aren't in any
+       lane aren't drawn. Inputs come first in the channel order, then outputs */
+    using Lanes = std::vector<std::vector<int>>;
+
+    /* preset lane layouts */
+    enum class Overlay {
+        none,               /* every channel gets its own lane */
+        inputsAndOutputs,   /* inputs are overlayed with each other in a single lane, same for outputs */
+        channels,           /* input and output n share lane n */
+        all                 /* everything overlayed in a single lane */
+    };
+
+    static Lanes makeLanes(Overlay overlay, int numInputChannels, int numOutputChannels) {
+        Lanes lanes;
+        auto numChannels = numInputChannels + numOutputChannels;
+        switch (overlay) {
+            case Overlay::inputsAndOutputs:
+                for (auto range : { juce::Range<int>(0, numInputChannels), juce::Range<int>(numInputChannels, numChannels) }) {
+                    if (range.isEmpty())
+                        continue;
+                    lanes.emplace_back();
+                    for (int channel = range.getStart(); channel < range.getEnd(); ++channel)
+                        lanes.back().push_back(channel);
+                }
                 break;
-            case OVERLAY_CHANNELS: /* each channel has its own window (ie, outputs and inputs of the same channel are overlayed with each other) */
-                paintOverlayedChannels(g, r);
+            case Overlay::channels:
+                lanes.resize((size_t)juce::jmax(numInputChannels, numOutputChannels));
+                for (int channel = 0; channel < numChannels; ++channel)
+                    lanes[(size_t)(channel < numInputChannels ? channel : channel - numInputChannels)].push_back(channel);
                 break;
-            case OVERLAY_ALL: /* everything overlayed in a single window */
-                paintAllOverlayed(g, r);
+            case Overlay::all:
+                lanes.emplace_back();
+                for (int channel = 0; channel < numChannels; ++channel)
+                    lanes.back().push_back(channel);
                 break;
-            default: // NO_OVERLAY
-                paintNoOverlay(g, r);
+            case Overlay::none:
+            default:
+                for (int channel = 0; channel < numChannels; ++channel)
+                    lanes.push_back({ channel });
                 break;
         }
+        return lanes;
+    }
+
+    AudioVisualiser() : AudioVisualiser(2, 0, Overlay::none) {}
+
+    AudioVisualiser(int numInputChannels, int numOutputChannels, Overlay overlay = Overlay::none) : numInputChannels(numInputChannels) {
+        history.prepare(numInputChannels + numOutputChannels, maxHistoryColumns);
+        setLayout(overlay);
+    }
+
+    /* use a preset layout. It follows changes in the channel count (extra channels count as outputs) */
+    void setLayout(Overlay newOverlay) {
+        overlay = newOverlay;
+        hasCustomLanes = false;
+        lanes = makeLanes(overlay, getNumInputChannels(), history.getNumChannels() - getNumInputChannels());
+        layoutStrips();
+    }
+
+    /* use any lane layout. It stays as given when the channel count changes */
+    void setLayout(const Lanes& newLanes) {
+        hasCustomLanes = true;
+        lanes = newLanes;
+        layoutStrips();
+    }
+
+    /* horizontal zoom, from 64 to 65536 samples per pixel column. Drawing costs the same at any zoom */
+    void setSamplesPerColumn(double newSamplesPerColumn) {
+        samplesPerColumn = juce::jlimit((double)magna::MinMaxPyramid::baseBlockSize, (double)magna::MinMaxPyramid::maxBlockSize, newSamplesPerColumn);
+        redrawStrips();
+    }
+
+    double getSamplesPerColumn() const noexcept { return samplesPerColumn; }
+
+    void clear() {
+        history.clear();
+        redrawStrips();
+    }
+
+    void resized() override {
+        layoutStrips();
+    }
+
+protected:
+    bool updateVisualiser() override {
+        return updateStrips();
+    }
+
+    /* only blits the cached strips; they are brought up to date on the timer */
+    void paintVisualiser(juce::Graphics& g) override {
+        g.fillAll(backgroundColour);
+
+        auto width = getStripWidth();
+        for (auto& strip : strips) {
+            auto height = strip.area.getHeight();
+            if (!strip.image.isValid() || height <= 0)
+                continue;
+            // the ring's oldest column is at stripWriteX, so it's drawn in two parts to put that column at the left edge
+            g.drawImage(strip.image, strip.area.getX(), strip.area.getY(), width - stripWriteX, height, stripWriteX, 0, width - stripWriteX, height);
+            if (stripWriteX > 0)
+                g.drawImage(strip.image, strip.area.getX() + width - stripWriteX, strip.area.getY(), stripWriteX, height, 0, 0, stripWriteX, height);
+        }
+    }
+
+    void pushSamples(const float** channelData, int numChannels, int numSamples) override {
+        history.push(channelData, numChannels, numSamples);
+    }
+
+    void sourceChannelsChanged(int numChannels) override {
+        if (numChannels == history.getNumChannels())
+            return;
+        history.prepare(numChannels, maxHistoryColumns);
+        if (hasCustomLanes)
+            layoutStrips();
+        else
+            setLayout(overlay);
+    }
+
+    void channelColourChanged(int channel) override {
+        if ((size_t)channel < stripColours.size())
+            stripColours[(size_t)channel] = getChannelColour(channel);
+        redrawStrips();
+    }
+
+private:
+    static constexpr int maxHistoryColumns = 4096; // widest waveform that can be drawn at every zoom
+
+    magna::MinMaxPyramid history;
+    double samplesPerColumn = 256.0;
+    std::vector<juce::Range<float>> columnLevels; // scratch for one channel's new columns
+
+    /* One cached image per channel, used as a ring of pixel columns. Each timer tick draws only the columns the history completed since
+       the last one, at stripWriteX, so the cost follows the incoming samples rather than the size of the view */
+    struct ChannelStrip {
+        juce::Rectangle<int> area;
+        juce::Image image;
     };
+    std::vector<ChannelStrip> strips;
+    juce::int64 nextStripColumn = 0; // history column that goes at stripWriteX next
+    int stripWriteX = 0;
+    bool stripsNeedRedraw = true;
+
+    int numInputChannels;
+    Overlay overlay = Overlay::none;
+    bool hasCustomLanes = false;
+    Lanes lanes;
+
+    // computed from the lanes in layoutStrips(), so paint and the strip updates are plain indexed loops
+    std::vector<juce::Colour> stripColours;
+
+    int getNumInputChannels() const noexcept { return juce::jmin(numInputChannels, history.getNumChannels()); }
+
+    int getStripWidth() const noexcept {
+        return juce::jlimit(0, maxHistoryColumns, getWidth());
+    }
+
+    void redrawStrips() {
+        stripsNeedRedraw = true;
+        if (updateStrips())
+            repaint();
+    }
+
+    /* turns the lanes into one area (and colour) per channel and (re)allocates the strip images */
+    void layoutStrips() {
+        auto numChannels = history.getNumChannels();
+        auto bounds = getLocalBounds().withWidth(getStripWidth());
+        strips.assign((size_t)numChannels, {});
+        stripColours.resize((size_t)numChannels);
+
+        auto numLanes = (int)lanes.size();
+        for (int lane = 0; lane < numLanes; ++lane) {
+            // lanes share the height evenly; the last one takes the rounding remainder
+            auto top = bounds.getY() + bounds.getHeight() * lane / numLanes;
+            auto bottom = bounds.getY() + bounds.getHeight() * (lane + 1) / numLanes;
+            for (auto channel : lanes[(size_t)lane])
+                if (channel >= 0 && channel < numChannels)
+                    strips[(size_t)channel].area = bounds.withY(top).withBottom(bottom);
+        }
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            auto& strip = strips[(size_t)channel];
+            stripColours[(size_t)channel] = getChannelColour(channel);
+            if (!strip.area.isEmpty())
+                strip.image = juce::Image(juce::Image::ARGB, strip.area.getWidth(), strip.area.getHeight(), true);
+        }
+
+        redrawStrips();
+    }
+
+    /* draws the columns completed since the last call into the strips (or all of them after a change). Returns true if anything was drawn */
+    bool updateStrips() {
+        auto width = getStripWidth();
+        if (strips.empty() || width <= 0)
+            return false;
+
+        auto numColumns = history.getNumColumns(samplesPerColumn);
+        auto numNew = numColumns - nextStripColumn;
+
+        if (stripsNeedRedraw || numNew < 0 || numNew >= width) {
+            stripsNeedRedraw = false;
+            stripWriteX = 0;
+            drawColumns(numColumns - width, width);
+        }
+        else if (numNew > 0) {
+            drawColumns(nextStripColumn, (int)numNew);
+        }
+        else {
+            return false;
+        }
+
+        nextStripColumn = numColumns;
+        return true;
+    }
+
+    /* draws history columns {firstColumn, firstColumn + numColumns) at stripWriteX onwards, wrapping around the ring */
+    void drawColumns(juce::int64 firstColumn, int numColumns) {
+        auto width = getStripWidth();
+        columnLevels.resize((size_t)numColumns);
+
+        for (size_t channel = 0; channel < strips.size(); ++channel) {
+            auto& image = strips[channel].image;
+            if (!image.isValid())
+                continue;
+
+            history.getColumns((int)channel, samplesPerColumn, firstColumn, columnLevels.data(), numColumns);
+
+            auto halfHeight = 0.5f * (float)image.getHeight();
+            auto firstSpan = juce::jmin(numColumns, width - stripWriteX);
+            image.clear({ stripWriteX, 0, firstSpan, image.getHeight() });
+            if (numColumns > firstSpan)
+                image.clear({ 0, 0, numColumns - firstSpan, image.getHeight() });
+
+            juce::Graphics g(image);
+            g.setColour(stripColours[channel]);
+            for (int i = 0; i < numColumns; ++i) {
+                auto& level = columnLevels[(size_t)i];
+                auto top = halfHeight * (1.0f - juce::jlimit(-1.0f, 1.0f, level.getEnd()));
+                auto bottom = halfHeight * (1.0f - juce::jlimit(-1.0f, 1.0f, level.getStart()));
+                g.fillRect(juce::Rectangle<float>((float)((stripWriteX + i) % width), top, 1.0f, juce::jmax(1.0f, bottom - top)));
+            }
+        }
+
+        stripWriteX = (stripWriteX + numColumns) % width;
+    }
+};
+
+/* FREQUENCY VISUALISER */
+
+/* Spectrum view. Samples from the source go to a magna::SpectrumAnalyser running on its own thread; the message thread only turns its
+   published band levels into paths (when they change, or on resize) and strokes them */
+class FrequencyVisualiser : public AudioFeedVisualiser {
+public:
+    FrequencyVisualiser() {}
+    ~FrequencyVisualiser() override {}
+
+    /* (re)starts the analysis. Call again whenever the sample rate or channel count changes */
+    void prepare(double sampleRate, int numChannels, const magna::SpectrumAnalyser::Settings& settings = {}) {
+        analyser.prepare(sampleRate, numChannels, settings);
+        levels.clear();
+        peaks.clear();
+        rebuildPaths();
+    }
+
+    void resized() override {
+        rebuildPaths();
+    }
+
+protected:
+    void paintVisualiser(juce::Graphics& g) override {
+        g.fillAll(backgroundColour);
+
+        for (size_t channel = 0; channel < levelPaths.size(); ++channel) {
+            auto colour = getChannelColour((int)channel);
+            g.setColour(colour.withAlpha(0.5f));
+            g.strokePath(peakPaths[channel], juce::PathStrokeType(1.0f));
+            g.setColour(colour);
+            g.strokePath(levelPaths[channel], juce::PathStrokeType(1.5f));
+        }
+    }
+
+    bool updateVisualiser() override {
+        if (!analyser.getLatestResults(levels, peaks))
+            return false;
+        rebuildPaths();
+        return true;
+    }
+
+    void pushSamples(const float** channelData, int numChannels, int numSamples) override {
+        analyser.push(channelData, numChannels, numSamples);
+    }
 
 private:
-    int numInputChannels, numOutputChannels;
-    std::uint8_t overlayChannels = NO_OVERLAY;
-    juce::Colour channelColours[4] = { juce::Colours::seagreen, juce::Colours::blue, juce::Colours::red, juce::Colours::purple };
-    //std::vector<juce::Colour> componentColors;
+    magna::SpectrumAnalyser analyser;
+    std::vector<float> levels, peaks; // numChannels * numBands, channel after channel
+    std::vector<juce::Path> levelPaths, peakPaths;
+
+    void rebuildPaths() {
+        auto numBands = analyser.getSettings().numBands;
+        auto numChannels = numBands > 0 ? (int)levels.size() / numBands : 0;
+        levelPaths.resize((size_t)numChannels);
+        peakPaths.resize((size_t)numChannels);
+
+        auto area = getLocalBounds().toFloat();
+        auto bandWidth = area.getWidth() / (float)juce::jmax(1, numBands - 1);
 
-    void paintNoOverlay(juce::Graphics& g, juce::Rectangle<float>& area) {
-        auto channelHeight = area.getHeight() / (float)(numInputChannels + numOutputChannels);
-        auto channelColorIndex = 1;
-        for (auto* c : channels) {
-            g.setColour(channelColours[channelColorIndex++]);//componentColors.at(channelColorIndex++));
-            paintChannel(g, area.removeFromTop(channelHeight), c->levels.begin(), c->levels.size(), c->nextSample);
+        for (int channel = 0; channel < numChannels; ++channel) {
+            auto build = [&](juce::Path& path, const float* values) {
+                path.clear();
+                path.preallocateSpace(3 * numBands);
+                for (int band = 0; band < numBands; ++band) {
+                    auto x = area.getX() + bandWidth * (float)band;
+                    auto y = area.getBottom() - area.getHeight() * juce::jlimit(0.0f, 1.0f, values[band]);
+                    if (band == 0)
+                        path.startNewSubPath(x, y);
+                    else
+                        path.lineTo(x, y);
+                }
+            };
+            build(levelPaths[(size_t)channel], levels.data() + channel * numBands);
+            build(peakPaths[(size_t)channel], peaks.data() + channel * numBands);
         }
     }
+};
+
+/* SPECTROGRAM */
+
+/* Scrolling spectrogram (waterfall): time runs left to right, frequency bottom to top on the analyser's log band scale. Every frame the
+   magna::SpectrumAnalyser queues becomes one pixel column, written at writeX into an image used as a ring of columns, through a
+   precomputed colour table; paint blits the ring in two parts. So each tick costs one column of pixels per new frame, however wide the view */
+class SpectrogramVisualiser : public AudioFeedVisualiser {
+public:
+    SpectrogramVisualiser() {
+        setColourMap(makeDefaultColourMap());
+    }
+    ~SpectrogramVisualiser() override {}
+
+    /* (re)starts the analysis. Call again whenever the sample rate or channel count changes. One column is drawn every settings.hop samples */
+    void prepare(double sampleRate, int numChannels, const magna::SpectrumAnalyser::Settings& settings = {}) {
+        analyser.prepare(sampleRate, numChannels, settings);
+        analyser.setFrameHistoryEnabled(true);
+        frameBuffer.setSize(analyser.getSettings().numBands, 64);
+        layoutImage();
+    }
+
+    /* level {0.0, 1.0} to colour, positioned along the gradient */
+    void setColourMap(const juce::ColourGradient& gradient) {
+        for (int i = 0; i < colourTableSize; ++i)
+            colourTable[i] = gradient.getColourAtPosition((double)i / (double)(colourTableSize - 1)).getPixelARGB();
+        silenceColour = gradient.getColourAtPosition(0.0);
+        clearImage();
+        repaint();
+    }
+
+    static juce::ColourGradient makeDefaultColourMap() {
+        juce::ColourGradient gradient(juce::Colours::black, 0.0f, 0.0f, juce::Colours::white, 1.0f, 0.0f, false);
+        gradient.addColour(0.25, juce::Colours::darkblue);
+        gradient.addColour(0.5, juce::Colours::purple);
+        gradient.addColour(0.7, juce::Colours::red);
+        gradient.addColour(0.85, juce::Colours::yellow);
+        return gradient;
+    }
+
+    void resized() override {
+        layoutImage();
+    }
 
-    // TODO: can potentially save computation time by NOT painting pixels that are already painted over?
+protected:
+    void paintVisualiser(juce::Graphics& g) override {
+        g.fillAll(backgroundColour);
+        if (!waterfall.isValid())
+            return;
 
-    void paintOverlayedIO(juce::Graphics& g, juce::Rectangle<float>& area) {
-        auto channelHeight = (numInputChannels && numOutputChannels) ? 0.5f * area.getHeight() : area.getHeight();
-        auto channelColorIndex = 1;
-        for (auto* c : channels) {
-            g.setColour(channelColours[channelColorIndex]);//componentColors.at(channelColorIndex));
-            if (channelColorIndex < numInputChannels - 1) { /* don't want to remove top from r yet, so instead I pass a new rectangle with proper dimensions */
-                paintChannel(g, juce::Rectangle<float>(area.getX(), area.getY(), area.getWidth(), channelHeight), c->levels.begin(), c->levels.size(), c->nextSample);
+        // the oldest column is at writeX, so it's drawn in two parts to put that column at the left edge
+        auto width = waterfall.getWidth(), height = waterfall.getHeight();
+        g.drawImage(waterfall, 0, 0, width - writeX, height, writeX, 0, width - writeX, height);
+        if (writeX > 0)
+            g.drawImage(waterfall, width - writeX, 0, writeX, height, 0, 0, writeX, height);
+    }
+
+    bool updateVisualiser() override {
+        bool drewAnything = false;
+        for (int numRead = analyser.popFrames(frameBuffer); numRead > 0; numRead = analyser.popFrames(frameBuffer)) {
+            drawFrames(numRead);
+            drewAnything = true;
+        }
+        return drewAnything;
+    }
+
+    void pushSamples(const float** channelData, int numChannels, int numSamples) override {
+        analyser.push(channelData, numChannels, numSamples);
+    }
+
+private:
+    static constexpr int colourTableSize = 256;
+
+    magna::SpectrumAnalyser analyser;
+    juce::AudioBuffer<float> frameBuffer; // one channel per band, one sample per frame
+
+    juce::Image waterfall;
+    int writeX = 0;
+    std::vector<int> rowBands; // band shown in each pixel row, top row first
+    juce::PixelARGB colourTable[colourTableSize];
+    juce::Colour silenceColour;
+
+    void layoutImage() {
+        auto width = getWidth(), height = getHeight();
+        waterfall = width > 0 && height > 0 ? juce::Image(juce::Image::ARGB, width, height, false) : juce::Image();
+        writeX = 0;
+        clearImage();
+
+        auto numBands = analyser.getSettings().numBands;
+        rowBands.resize((size_t)juce::jmax(0, height));
+        for (int y = 0; y < height; ++y)
+            rowBands[(size_t)y] = juce::jlimit(0, numBands - 1, (height - 1 - y) * numBands / height);
+    }
+
+    void clearImage() {
+        if (waterfall.isValid())
+            waterfall.clear(waterfall.getBounds(), silenceColour);
+    }
+
+    /* writes the first numFrames frames of frameBuffer as columns at writeX onwards, wrapping around the ring */
+    void drawFrames(int numFrames) {
+        if (!waterfall.isValid() || frameBuffer.getNumChannels() == 0)
+            return;
+
+        auto width = waterfall.getWidth(), height = waterfall.getHeight();
+        auto firstFrame = juce::jmax(0, numFrames - width); // older frames would be overwritten in this same pass
+        juce::Image::BitmapData pixels(waterfall, juce::Image::BitmapData::writeOnly);
+        auto scale = (float)(colourTableSize - 1);
+
+        for (int frame = firstFrame; frame < numFrames; ++frame) {
+            for (int y = 0; y < height; ++y) {
+                auto level = frameBuffer.getSample(rowBands[(size_t)y], frame);
+                auto index = juce::jlimit(0, colourTableSize - 1, (int)(level * scale));
+                *reinterpret_cast<juce::PixelARGB*>(pixels.getPixelPointer(writeX, y)) = colourTable[index];
             }
-            else if (channelColorIndex == (numInputChannels - 1)) { /* final input (top) channel, so remove from r */
-                paintChannel(g, area.removeFromTop(channelHeight), c->levels.begin(), c->levels.size(), c->nextSample);
+            writeX = (writeX + 1) % width;
+        }
+    }
+};
+
+/* GONIOMETER */
+
+/* Vectorscope of one stereo pair (mid up, side across) with correlation and balance meters underneath. The mid/side points and the
+   meter values come from a magna::StereoFieldAnalyser on its own thread; the message thread fades the accumulation image a little every
+   tick, plots the new points into it and blits it */
+class GoniometerVisualiser : public AudioFeedVisualiser {
+public:
+    GoniometerVisualiser() {}
+    ~GoniometerVisualiser() override {}
+
+    /* (re)starts the analysis. Call again whenever the sample rate changes */
+    void prepare(double sampleRate) {
+        analyser.prepare(sampleRate);
+        pointBuffer.setSize(2, 2048);
+        if (scope.isValid())
+            scope.clear(scope.getBounds());
+    }
+
+    /* which source channels make up the pair (e.g. the outputs when the source carries inputs then outputs) */
+    void setStereoPair(int newLeftChannel, int newRightChannel) {
+        leftChannel = newLeftChannel;
+        rightChannel = newRightChannel;
+    }
+
+    /* how long a plotted point takes to fade to half its brightness */
+    void setFadeHalfLife(double seconds) {
+        fadeHalfLifeSeconds = juce::jmax(0.01, seconds);
+    }
+
+    void resized() override {
+        auto bounds = getLocalBounds();
+        balanceArea = bounds.removeFromBottom(meterHeight).reduced(4, 2);
+        correlationArea = bounds.removeFromBottom(meterHeight).reduced(4, 2);
+        auto size = juce::jmin(bounds.getWidth(), bounds.getHeight());
+        scopeArea = bounds.withSizeKeepingCentre(size, size);
+        scope = size > 0 ? juce::Image(juce::Image::ARGB, size, size, true) : juce::Image();
+    }
+
+protected:
+    void paintVisualiser(juce::Graphics& g) override {
+        g.fillAll(backgroundColour);
+
+        // L and R axes, and the unit circle
+        auto centre = scopeArea.getCentre().toFloat();
+        auto radius = 0.5f * (float)scopeArea.getWidth();
+        g.setColour(juce::Colours::grey.withAlpha(0.4f));
+        g.drawEllipse(scopeArea.toFloat(), 1.0f);
+        g.drawLine(centre.x - radius * 0.7071f, centre.y - radius * 0.7071f, centre.x + radius * 0.7071f, centre.y + radius * 0.7071f);
+        g.drawLine(centre.x + radius * 0.7071f, centre.y - radius * 0.7071f, centre.x - radius * 0.7071f, centre.y + radius * 0.7071f);
+
+        if (scope.isValid())
+            g.drawImageAt(scope, scopeArea.getX(), scopeArea.getY());
+
+        paintMeter(g, correlationArea, shownCorrelation, shownCorrelation < 0.0f ? juce::Colours::red : juce::Colours::seagreen, "-1", "+1");
+        paintMeter(g, balanceArea, shownBalance, juce::Colours::seagreen, "L", "R");
+    }
+
+    /* once the last points have faded out (ten half-lives) and the meters are still, there's nothing new to draw */
+    bool updateVisualiser() override {
+        auto now = juce::Time::getMillisecondCounterHiRes();
+        auto elapsedSeconds = lastTickMs > 0.0 ? (now - lastTickMs) * 0.001 : 0.0;
+        lastTickMs = now;
+
+        bool changed = false;
+        if (scope.isValid()) {
+            secondsSinceLastPoint += elapsedSeconds;
+            if (secondsSinceLastPoint < 10.0 * fadeHalfLifeSeconds) {
+                scope.multiplyAllAlphas((float)std::pow(0.5, elapsedSeconds / fadeHalfLifeSeconds));
+                changed = true;
             }
-            else {
-                paintChannel(g, area, c->levels.begin(), c->levels.size(), c->nextSample);
+            if (plotNewPoints()) {
+                secondsSinceLastPoint = 0.0;
+                changed = true;
             }
-            channelColorIndex++;
         }
-    }
 
-    void paintOverlayedChannels(juce::Graphics& g, juce::Rectangle<float>& area) {
-        auto channelHeight = (numInputChannels < 2 && numOutputChannels < 2) ? area.getHeight() : area.getHeight() * 0.5f;
-        int numWindows = (numInputChannels > numOutputChannels) ? numInputChannels : numOutputChannels;
-        auto channelColorIndex = 1;
-        for (auto* c : channels) {
-            g.setColour(channelColours[channelColorIndex]);//componentColors.at(channelColorIndex));
-            /* (channelColorIndex % numWindows) tells us which window to paint channel in */
-            paintChannel(g, juce::Rectangle<float>(area.getX(), area.getY() + channelHeight * (channelColorIndex % numWindows), area.getWidth(), channelHeight), c->levels.begin(), c->levels.size(), c->nextSample);
-            channelColorIndex++;
+        auto correlation = analyser.getCorrelation(), balance = analyser.getBalance();
+        if (correlation != shownCorrelation || balance != shownBalance) {
+            shownCorrelation = correlation;
+            shownBalance = balance;
+            changed = true;
         }
+        return changed;
     }
 
-    void paintAllOverlayed(juce::Graphics& g, juce::Rectangle<float>& area) {
-        auto channelColorIndex = 1;
-        for (auto* c : channels) {
-            g.setColour(channelColours[channelColorIndex++]);//componentColors.at(channelColorIndex++));
-            paintChannel(g, area, c->levels.begin(), c->levels.size(), c->nextSample);
+    void pushSamples(const float** channelData, int numChannels, int numSamples) override {
+        if (juce::jmax(leftChannel, rightChannel) < numChannels)
+            analyser.push(channelData[leftChannel], channelData[rightChannel], numSamples);
+    }
+
+private:
+    static constexpr int meterHeight = 14;
+
+    magna::StereoFieldAnalyser analyser;
+    juce::AudioBuffer<float> pointBuffer; // side, mid
+    int leftChannel = 0, rightChannel = 1;
+
+    juce::Image scope; // accumulation image, faded every tick
+    juce::Rectangle<int> scopeArea, correlationArea, balanceArea;
+    double fadeHalfLifeSeconds = 0.15;
+    double lastTickMs = 0.0, secondsSinceLastPoint = 0.0;
+    float shownCorrelation = 1.0f, shownBalance = 0.0f;
+
+    /* returns true if there were any */
+    bool plotNewPoints() {
+        if (pointBuffer.getNumSamples() == 0)
+            return false;
+
+        juce::Image::BitmapData pixels(scope, juce::Image::BitmapData::readWrite);
+        auto size = scope.getWidth();
+        auto half = 0.5f * (float)size;
+        auto colour = juce::PixelARGB(getChannelColour(leftChannel).withAlpha(0.35f).getPixelARGB());
+        bool plotted = false;
+
+        for (int numRead = analyser.popPoints(pointBuffer); numRead > 0; numRead = analyser.popPoints(pointBuffer)) {
+            const auto* side = pointBuffer.getReadPointer(0);
+            const auto* mid = pointBuffer.getReadPointer(1);
+            for (int i = 0; i < numRead; ++i) {
+                auto x = (int)(half + side[i] * half);
+                auto y = (int)(half - mid[i] * half);
+                if (x >= 0 && x < size && y >= 0 && y < size)
+                    reinterpret_cast<juce::PixelARGB*>(pixels.getPixelPointer(x, y))->blend(colour);
+            }
+            plotted = true;
         }
+        return plotted;
+    }
+
+    /* a bar from the centre of area towards value ({-1.0, 1.0}) */
+    void paintMeter(juce::Graphics& g, juce::Rectangle<int> area, float value, juce::Colour colour, const juce::String& minLabel, const juce::String& maxLabel) {
+        auto bar = area.toFloat();
+        g.setColour(juce::Colours::grey.withAlpha(0.3f));
+        g.fillRect(bar);
+
+        auto centreX = bar.getCentreX();
+        auto x = centreX + 0.5f * bar.getWidth() * juce::jlimit(-1.0f, 1.0f, value);
+        g.setColour(colour);
+        g.fillRect(juce::Rectangle<float>(juce::jmin(centreX, x), bar.getY(), std::abs(x - centreX), bar.getHeight()));
+
+        g.setColour(juce::Colours::white);
+        g.setFont((float)area.getHeight());
+        g.drawText(minLabel, area, juce::Justification::centredLeft, false);
+        g.drawText(maxLabel, area, juce::Justification::centredRight, false);
     }
 };
 
-/* FREQUENCY VISUALISER */
+/* LOUDNESS METER */
 
-class FrequencyVisualiser : public AudioVisualiser {
+/* BS.1770 / EBU R128 meter: momentary and short-term bars against a target line, with the integrated loudness and true peak read out
+   beside them. The measuring happens in a magna::LoudnessAnalyser on its own thread; the message thread only reads four numbers and
+   repaints when they change. Clicking the meter restarts the integrated loudness and true peak */
+class LoudnessVisualiser : public AudioFeedVisualiser {
 public:
-    FrequencyVisualiser() {}
-    ~FrequencyVisualiser() override {}
+    LoudnessVisualiser() {}
+    ~LoudnessVisualiser() override {}
 
-    void paintChannel(juce::Graphics& g, juce::Rectangle<float> area, const juce::Range<float>* levels, int numLevels, int nextSample) override {
-    
+    /* (re)starts the analysis. One weight per measured channel (1.0 for L/R/C, 1.41 for surrounds, 0.0 for LFE); call again whenever the
+       sample rate or channel count changes */
+    void prepare(double sampleRate, std::vector<float> channelWeights = { 1.0f, 1.0f }) {
+        auto numChannels = (int)channelWeights.size();
+        analyser.prepare(sampleRate, numChannels, std::move(channelWeights));
+    }
+
+    /* the first source channel measured (e.g. the first output when the source carries inputs then outputs) */
+    void setFirstChannel(int newFirstChannel) {
+        firstChannel = juce::jmax(0, newFirstChannel);
+    }
+
+    /* in LUFS, drawn as a line across the bars (-23 for EBU R128 broadcast, around -14 for streaming) */
+    void setTargetLoudness(float lufs) {
+        targetLoudness = lufs;
+        repaint();
+    }
+
+    void mouseDown(const juce::MouseEvent&) override {
+        analyser.reset();
+    }
+
+protected:
+    void paintVisualiser(juce::Graphics& g) override {
+        g.fillAll(backgroundColour);
+
+        auto bounds = getLocalBounds().reduced(4);
+        auto readoutArea = bounds.removeFromRight(juce::jmin(bounds.getWidth() / 2, 120));
+        auto momentaryBar = bounds.removeFromLeft(bounds.getWidth() / 2).reduced(2, 0);
+        auto shortTermBar = bounds.reduced(2, 0);
+
+        paintBar(g, momentaryBar, shown.momentary, "M");
+        paintBar(g, shortTermBar, shown.shortTerm, "S");
+
+        auto format = [](float value) {
+            return value > magna::LoudnessAnalyser::minimumLoudness ? juce::String(value, 1) : juce::String("-inf");
+        };
+        auto lineHeight = juce::jmin(20, readoutArea.getHeight() / 4);
+        g.setFont((float)lineHeight * 0.8f);
+        auto readout = [&](const juce::String& text, juce::Colour colour) {
+            g.setColour(colour);
+            g.drawText(text, readoutArea.removeFromTop(lineHeight), juce::Justification::centredLeft, false);
+        };
+        readout("M  " + format(shown.momentary) + " LUFS", juce::Colours::white);
+        readout("S  " + format(shown.shortTerm) + " LUFS", juce::Colours::white);
+        readout("I  " + format(shown.integrated) + " LUFS", juce::Colours::white);
+        readout("TP " + format(shown.truePeak) + " dBTP", shown.truePeak > truePeakLimit ? juce::Colours::red : juce::Colours::white);
+    }
+
+    bool updateVisualiser() override {
+        Readings latest{ analyser.getMomentaryLoudness(), analyser.getShortTermLoudness(), analyser.getIntegratedLoudness(), analyser.getTruePeak() };
+        if (latest == shown)
+            return false;
+        shown = latest;
+        return true;
+    }
+
+    void pushSamples(const float** channelData, int numChannels, int numSamples) override {
+        if (firstChannel < numChannels)
+            analyser.push(channelData + firstChannel, numChannels - firstChannel, numSamples);
     }
 
 private:
-    bool ready = false;
-};
\ No newline at end of file
+    static constexpr float meterFloor = -60.0f, meterCeiling = 0.0f, truePeakLimit = -1.0f;
+
+    struct Readings {
+        float momentary = magna::LoudnessAnalyser::minimumLoudness, shortTerm = magna::LoudnessAnalyser::minimumLoudness;
+        float integrated = magna::LoudnessAnalyser::minimumLoudness, truePeak = magna::LoudnessAnalyser::minimumLoudness;
+
+        bool operator==(const Readings& other) const noexcept {
+            return momentary == other.momentary && shortTerm == other.shortTerm && integrated == other.integrated && truePeak == other.truePeak;
+        }
+    };
+
+    magna::LoudnessAnalyser analyser;
+    Readings shown;
+    int firstChannel = 0;
+    float targetLoudness = -23.0f;
+
+    float loudnessToY(juce::Rectangle<float> area, float lufs) const noexcept {
+        return juce::jmap(juce::jlimit(meterFloor, meterCeiling, lufs), meterFloor, meterCeiling, area.getBottom(), area.getY());
+    }
+
+    void paintBar(juce::Graphics& g, juce::Rectangle<int> area, float lufs, const juce::String& label) {
+        auto labelArea = area.removeFromBottom(14);
+        auto bar = area.toFloat();
+        g.setColour(juce::Colours::grey.withAlpha(0.3f));
+        g.fillRect(bar);
+
+        auto top = loudnessToY(bar, lufs);
+        g.setColour(lufs > targetLoudness ? juce::Colours::orange : juce::Colours::seagreen);
+        g.fillRect(bar.withTop(top));
+
+        g.setColour(juce::Colours::white);
+        auto targetY = loudnessToY(bar, targetLoudness);
+        g.drawLine(bar.getX(), targetY, bar.getRight(), targetY, 1.0f);
+        g.setFont(12.0f);
+        g.drawText(label, labelArea, juce::Justification::centred, false);
+    }
+};
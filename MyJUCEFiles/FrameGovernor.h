@@ -0,0 +1,126 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace magna {
+
+	/* Adaptive frame rate for components that redraw on a timer. The owner reports the start and end of every tick and how long each paint
+	took; every adaptIntervalMs the governor picks a new rate within {minHz, maxHz}:
+	- down by a third if ticks arrive late (the message thread is saturated), if a frame's work takes more than a quarter of the frame, or if
+	  all governors together are using more than maxSharedLoad of the message thread
+	- up by a quarter once all of those are comfortably clear again.
+	The shared load is what keeps many open editors from starving the GUI. Message thread only, like the timers and paints it measures */
+	class FrameGovernor {
+	public:
+		struct Statistics {
+			int frameRateHz = 0;
+			double averageUpdateMs = 0.0;		// per tick, painted or not
+			double averagePaintMs = 0.0, maxPaintMs = 0.0;
+			double averageTickLatenessMs = 0.0;	// how late ticks arrive against the current rate
+			double sharedLoad = 0.0;			// fraction of the message thread used by every governed component, over the last second
+			juce::int64 framesPainted = 0, framesSkipped = 0; // skipped = ticks where nothing changed, so no repaint was asked for
+		};
+
+		static constexpr double adaptIntervalMs = 500.0;
+		static constexpr double maxSharedLoad = 0.5;
+
+		FrameGovernor(int minHz = 10, int maxHz = 60) { setFrameRateRange(minHz, maxHz); }
+
+		/* starts again from maxHz */
+		void setFrameRateRange(int newMinHz, int newMaxHz) noexcept {
+			minHz = juce::jmax(1, newMinHz);
+			maxHz = juce::jmax(minHz, newMaxHz);
+			frameRate = maxHz;
+			lastTickMs = 0.0;
+			statistics.frameRateHz = frameRate;
+		}
+
+		int getFrameRate() const noexcept { return frameRate; }
+		const Statistics& getStatistics() const noexcept { return statistics; }
+
+		void resetStatistics() noexcept {
+			statistics = {};
+			statistics.frameRateHz = frameRate;
+		}
+
+		void beginTick() noexcept {
+			auto now = juce::Time::getMillisecondCounterHiRes();
+			if (lastTickMs > 0.0)
+				average(statistics.averageTickLatenessMs, juce::jmax(0.0, now - lastTickMs - 1000.0 / (double)frameRate));
+			lastTickMs = tickStartMs = now;
+		}
+
+		/* returns true if the frame rate changed, in which case the owner restarts its timer at getFrameRate() */
+		bool endTick(bool frameChanged) noexcept {
+			auto now = juce::Time::getMillisecondCounterHiRes();
+			auto elapsed = now - tickStartMs;
+			average(statistics.averageUpdateMs, elapsed);
+			getSharedLoad().busyMs += elapsed;
+			if (!frameChanged)
+				++statistics.framesSkipped;
+			return adapt(now);
+		}
+
+		void paintFinished(double paintMs) noexcept {
+			average(statistics.averagePaintMs, paintMs);
+			statistics.maxPaintMs = juce::jmax(statistics.maxPaintMs, paintMs);
+			++statistics.framesPainted;
+			getSharedLoad().busyMs += paintMs;
+		}
+
+	private:
+		struct SharedLoad {
+			double windowStartMs = 0.0, busyMs = 0.0, load = 0.0;
+		};
+
+		int minHz = 10, maxHz = 60, frameRate = 60;
+		double lastTickMs = 0.0, tickStartMs = 0.0, lastAdaptMs = 0.0;
+		Statistics statistics;
+
+		static SharedLoad& getSharedLoad() noexcept {
+			static SharedLoad shared;
+			return shared;
+		}
+
+		static void average(double& value, double newValue) noexcept {
+			value += 0.1 * (newValue - value);
+		}
+
+		/* the shared window rolls over once a second, whichever governor gets there first */
+		static double updateSharedLoad(double now) noexcept {
+			auto& shared = getSharedLoad();
+			auto elapsed = now - shared.windowStartMs;
+			if (elapsed >= 1000.0) {
+				shared.load = shared.windowStartMs > 0.0 ? shared.busyMs / elapsed : 0.0;
+				shared.windowStartMs = now;
+				shared.busyMs = 0.0;
+			}
+			return shared.load;
+		}
+
+		bool adapt(double now) noexcept {
+			statistics.sharedLoad = updateSharedLoad(now);
+			if (now - lastAdaptMs < adaptIntervalMs)
+				return false;
+			lastAdaptMs = now;
+
+			auto interval = 1000.0 / (double)frameRate;
+			auto busyPerFrame = statistics.averageUpdateMs + statistics.averagePaintMs;
+			auto newRate = frameRate;
+
+			if (statistics.averageTickLatenessMs > 0.5 * interval || busyPerFrame > 0.25 * interval || statistics.sharedLoad > maxSharedLoad)
+				newRate = juce::jmax(minHz, frameRate * 2 / 3);
+			else if (statistics.averageTickLatenessMs < 0.1 * interval && busyPerFrame < 0.1 * interval && statistics.sharedLoad < 0.5 * maxSharedLoad)
+				newRate = juce::jmin(maxHz, frameRate + juce::jmax(1, frameRate / 4));
+
+			if (newRate == frameRate)
+				return false;
+
+			frameRate = statistics.frameRateHz = newRate;
+			lastTickMs = 0.0; // the next interval is still at the old rate
+			statistics.averageTickLatenessMs = 0.0;
+			return true;
+		}
+	};
+
+}
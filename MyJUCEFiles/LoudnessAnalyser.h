@@ -0,0 +1,282 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ThreadFunctions.h" // AudioSampleFifo
+
+namespace magna {
+
+	/* ITU-R BS.1770-4 / EBU R128 loudness on a background thread: momentary (400ms), short-term (3s) and gated integrated loudness in LUFS,
+	plus the true peak in dBTP (4x oversampled, held until reset()).
+	Every channel is K-weighted (the BS.1770 shelf and high-pass biquads, recomputed for the actual sample rate) and its mean square is
+	summed per 100ms into weighted sub-blocks. The windows are sums of the last 4 or 30 sub-blocks, and every 400ms gating block (75% overlap)
+	lands in a 0.1 LU histogram, so the integrated loudness is a pass over the histogram instead of the whole programme */
+	class LoudnessAnalyser : private juce::Thread {
+	public:
+		LoudnessAnalyser() : juce::Thread("Loudness Analyser") {}
+		~LoudnessAnalyser() override { stopThread(1000); }
+
+		/* (re)starts the analysis thread. channelWeights are the BS.1770 weights per channel (1.0 for L/R/C, 1.41 for surrounds, 0.0 for LFE),
+		all 1.0 if empty. Call from the message thread */
+		void prepare(double newSampleRate, int newNumChannels, std::vector<float> channelWeights = {}) {
+			stopThread(1000);
+
+			sampleRate = newSampleRate;
+			numChannels = juce::jmax(1, newNumChannels);
+			weights = std::move(channelWeights);
+			weights.resize((size_t)numChannels, 1.0f);
+
+			input = std::make_unique<AudioSampleFifo>(numChannels, juce::jmax(8192, (int)sampleRate));
+			chunk.setSize(numChannels, 1024);
+			filters.assign((size_t)numChannels, {});
+			peakHistory.assign((size_t)(numChannels * tapsPerPhase), 0.0f);
+			computeKWeighting();
+			computeOversamplingFilter();
+
+			samplesPerSubBlock = juce::roundToInt(sampleRate * 0.1);
+			clearMeasurements();
+			resetRequested = false;
+
+			startThread();
+		}
+
+		/* producer side (one thread only). Never blocks */
+		void push(const float* const* channelData, int numChannelsToPush, int numSamples) noexcept {
+			if (input == nullptr)
+				return;
+			input->push(channelData, juce::jmin(numChannelsToPush, numChannels), numSamples);
+			notify();
+		}
+
+		/* restarts the integrated loudness and true peak. Safe from any thread; takes effect at the analysis thread's next pass */
+		void reset() noexcept { resetRequested = true; notify(); }
+
+		// in LUFS (or dBTP), or -infinity (minimumLoudness) until there is something to measure
+		float getMomentaryLoudness() const noexcept { return momentary.load(std::memory_order_relaxed); }
+		float getShortTermLoudness() const noexcept { return shortTerm.load(std::memory_order_relaxed); }
+		float getIntegratedLoudness() const noexcept { return integrated.load(std::memory_order_relaxed); }
+		float getTruePeak() const noexcept { return truePeak.load(std::memory_order_relaxed); }
+
+		static constexpr float minimumLoudness = -150.0f;
+
+	private:
+		static constexpr int subBlocksPerMomentary = 4, subBlocksPerShortTerm = 30;
+		static constexpr float absoluteGate = -70.0f, relativeGate = -10.0f;
+		static constexpr float histogramStep = 0.1f, histogramMax = 5.0f;
+		static constexpr int histogramSize = (int)((histogramMax - absoluteGate) / histogramStep) + 1;
+		static constexpr int oversampling = 4, tapsPerPhase = 12;
+
+		double sampleRate = 48000.0;
+		int numChannels = 1;
+		std::vector<float> weights;
+		std::unique_ptr<AudioSampleFifo> input;
+		juce::AudioBuffer<float> chunk;
+
+		struct Biquad {
+			double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+			double z1 = 0.0, z2 = 0.0;
+
+			double process(double x) noexcept { // transposed direct form II
+				auto y = b0 * x + z1;
+				z1 = b1 * x - a1 * y + z2;
+				z2 = b2 * x - a2 * y;
+				return y;
+			}
+		};
+		struct ChannelFilter {
+			Biquad shelf, highPass;
+			double sumOfSquares = 0.0; // of the current sub-block
+		};
+		std::vector<ChannelFilter> filters;
+		Biquad shelfPrototype, highPassPrototype;
+
+		// true peak: a 48 tap windowed-sinc interpolator, split into 4 phases of 12 taps
+		float oversamplingTaps[oversampling][tapsPerPhase] = {};
+		std::vector<float> peakHistory; // [channel][tapsPerPhase], newest first
+		float peak = 0.0f;
+
+		int samplesPerSubBlock = 4800, samplesInSubBlock = 0;
+		double subBlocks[subBlocksPerShortTerm] = {}; // weighted mean squares, a ring
+		int subBlockIndex = 0, numSubBlocks = 0;
+		int histogramCount[histogramSize] = {};
+		double histogramEnergy[histogramSize] = {};
+
+		std::atomic<float> momentary{ minimumLoudness }, shortTerm{ minimumLoudness }, integrated{ minimumLoudness }, truePeak{ minimumLoudness };
+		std::atomic<bool> resetRequested{ false };
+
+		static float energyToLoudness(double energy) noexcept {
+			return energy > 0.0 ? (float)(-0.691 + 10.0 * std::log10(energy)) : minimumLoudness;
+		}
+
+		void computeKWeighting() {
+			auto pi = juce::MathConstants<double>::pi;
+
+			// stage 1: high shelf, +4dB above ~1.7kHz
+			{
+				const auto f0 = 1681.974450955533, gain = 3.999843853973347, q = 0.7071752369554196;
+				auto k = std::tan(pi * f0 / sampleRate);
+				auto vh = std::pow(10.0, gain / 20.0);
+				auto vb = std::pow(vh, 0.4996667741545416);
+				auto a0 = 1.0 + k / q + k * k;
+				shelfPrototype.b0 = (vh + vb * k / q + k * k) / a0;
+				shelfPrototype.b1 = 2.0 * (k * k - vh) / a0;
+				shelfPrototype.b2 = (vh - vb * k / q + k * k) / a0;
+				shelfPrototype.a1 = 2.0 * (k * k - 1.0) / a0;
+				shelfPrototype.a2 = (1.0 - k / q + k * k) / a0;
+			}
+			// stage 2: RLB high-pass at ~38Hz
+			{
+				const auto f0 = 38.13547087602444, q = 0.5003270373238773;
+				auto k = std::tan(pi * f0 / sampleRate);
+				auto a0 = 1.0 + k / q + k * k;
+				highPassPrototype.b0 = 1.0;
+				highPassPrototype.b1 = -2.0;
+				highPassPrototype.b2 = 1.0;
+				highPassPrototype.a1 = 2.0 * (k * k - 1.0) / a0;
+				highPassPrototype.a2 = (1.0 - k / q + k * k) / a0;
+			}
+
+			for (auto& filter : filters) {
+				filter.shelf = shelfPrototype;
+				filter.highPass = highPassPrototype;
+			}
+		}
+
+		void computeOversamplingFilter() {
+			const int numTaps = oversampling * tapsPerPhase;
+			const auto centre = 0.5 * (double)(numTaps - 1);
+			for (int n = 0; n < numTaps; ++n) {
+				auto x = ((double)n - centre) / (double)oversampling;
+				auto sinc = std::abs(x) < 1.0e-9 ? 1.0 : std::sin(juce::MathConstants<double>::pi * x) / (juce::MathConstants<double>::pi * x);
+				// Blackman window
+				auto phase = juce::MathConstants<double>::twoPi * (double)n / (double)(numTaps - 1);
+				auto window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+				oversamplingTaps[n % oversampling][n / oversampling] = (float)(sinc * window);
+			}
+		}
+
+		void clearMeasurements() noexcept {
+			std::fill(std::begin(subBlocks), std::end(subBlocks), 0.0);
+			std::fill(std::begin(histogramCount), std::end(histogramCount), 0);
+			std::fill(std::begin(histogramEnergy), std::end(histogramEnergy), 0.0);
+			for (auto& filter : filters)
+				filter.sumOfSquares = 0.0;
+			subBlockIndex = numSubBlocks = samplesInSubBlock = 0;
+			peak = 0.0f;
+			momentary = shortTerm = integrated = truePeak = minimumLoudness;
+		}
+
+		void run() override {
+			while (!threadShouldExit()) {
+				wait(100);
+
+				if (resetRequested.exchange(false))
+					clearMeasurements();
+
+				for (int numRead = input->pop(chunk); numRead > 0 && !threadShouldExit(); numRead = input->pop(chunk))
+					analyse(numRead);
+			}
+		}
+
+		void analyse(int numSamples) noexcept {
+			int i = 0;
+			while (i < numSamples) {
+				auto runLength = juce::jmin(samplesPerSubBlock - samplesInSubBlock, numSamples - i);
+
+				for (int channel = 0; channel < numChannels; ++channel) {
+					const auto* data = chunk.getReadPointer(channel, i);
+					auto& filter = filters[(size_t)channel];
+					auto sum = 0.0;
+					for (int n = 0; n < runLength; ++n) {
+						auto y = filter.highPass.process(filter.shelf.process((double)data[n]));
+						sum += y * y;
+					}
+					filter.sumOfSquares += sum;
+					measureTruePeak(channel, data, runLength);
+				}
+
+				samplesInSubBlock += runLength;
+				i += runLength;
+				if (samplesInSubBlock == samplesPerSubBlock)
+					completeSubBlock();
+			}
+
+			truePeak.store(juce::Decibels::gainToDecibels(peak, minimumLoudness), std::memory_order_relaxed);
+		}
+
+		void measureTruePeak(int channel, const float* data, int numSamples) noexcept {
+			auto* history = peakHistory.data() + channel * tapsPerPhase;
+			for (int n = 0; n < numSamples; ++n) {
+				std::memmove(history + 1, history, sizeof(float) * (size_t)(tapsPerPhase - 1));
+				history[0] = data[n];
+
+				for (int phase = 0; phase < oversampling; ++phase) {
+					float y = 0.0f;
+					for (int tap = 0; tap < tapsPerPhase; ++tap)
+						y += oversamplingTaps[phase][tap] * history[tap];
+					peak = juce::jmax(peak, std::abs(y));
+				}
+			}
+		}
+
+		void completeSubBlock() noexcept {
+			double energy = 0.0;
+			for (int channel = 0; channel < numChannels; ++channel) {
+				auto& filter = filters[(size_t)channel];
+				energy += (double)weights[(size_t)channel] * filter.sumOfSquares / (double)samplesPerSubBlock;
+				filter.sumOfSquares = 0.0;
+			}
+			samplesInSubBlock = 0;
+
+			subBlocks[subBlockIndex] = energy;
+			subBlockIndex = (subBlockIndex + 1) % subBlocksPerShortTerm;
+			numSubBlocks = juce::jmin(numSubBlocks + 1, subBlocksPerShortTerm);
+
+			auto windowEnergy = [this](int numBlocks) {
+				double sum = 0.0;
+				for (int k = 1; k <= numBlocks; ++k)
+					sum += subBlocks[(subBlockIndex - k + subBlocksPerShortTerm) % subBlocksPerShortTerm];
+				return sum / (double)numBlocks;
+			};
+
+			if (numSubBlocks >= subBlocksPerMomentary) {
+				auto gatingBlockEnergy = windowEnergy(subBlocksPerMomentary);
+				auto loudness = energyToLoudness(gatingBlockEnergy);
+				momentary.store(loudness, std::memory_order_relaxed);
+
+				if (loudness >= absoluteGate) {
+					auto bin = juce::jmin(histogramSize - 1, (int)((loudness - absoluteGate) / histogramStep));
+					++histogramCount[bin];
+					histogramEnergy[bin] += gatingBlockEnergy;
+					updateIntegrated();
+				}
+			}
+			if (numSubBlocks >= subBlocksPerShortTerm)
+				shortTerm.store(energyToLoudness(windowEnergy(subBlocksPerShortTerm)), std::memory_order_relaxed);
+		}
+
+		/* two passes over the histogram: the mean of everything above the absolute gate sets the relative gate, then the mean above both */
+		void updateIntegrated() noexcept {
+			double energy = 0.0;
+			int count = 0;
+			for (int bin = 0; bin < histogramSize; ++bin) {
+				energy += histogramEnergy[bin];
+				count += histogramCount[bin];
+			}
+			if (count == 0)
+				return;
+
+			auto gate = energyToLoudness(energy / (double)count) + relativeGate;
+			auto firstBin = juce::jlimit(0, histogramSize, (int)std::ceil((gate - absoluteGate) / histogramStep));
+			energy = 0.0;
+			count = 0;
+			for (int bin = firstBin; bin < histogramSize; ++bin) {
+				energy += histogramEnergy[bin];
+				count += histogramCount[bin];
+			}
+			integrated.store(count > 0 ? energyToLoudness(energy / (double)count) : minimumLoudness, std::memory_order_relaxed);
+		}
+
+		JUCE_DECLARE_NON_COPYABLE(LoudnessAnalyser)
+	};
+
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace magna {
+
+	/* Multi-resolution min/max history of a multichannel signal, for drawing waveforms at any zoom. Level 0 holds the min/max of every
+	baseBlockSize samples, and each level above it halves the resolution of the one below, up to maxBlockSize samples per entry.
+	Levels are built incrementally as samples arrive (each input sample touches level 0, each finished entry touches the next level up),
+	and every level is a ring of the same number of entries. Reading numColumns columns at any zoom picks the level just below the zoom,
+	so it reads at most 2 * numColumns entries, however long the history is.
+	Columns are aligned to the start of the history rather than to the newest sample, so a column's contents never change once complete */
+	class MinMaxPyramid {
+	public:
+		static constexpr int baseBlockSize = 64;
+		static constexpr int maxBlockSize = 65536;
+		static constexpr int numLevels = 11; // 64 << 10 == 65536
+
+		/* allocates the rings. maxColumns is the widest view that can be read at every zoom */
+		void prepare(int newNumChannels, int maxColumns) {
+			numChannels = juce::jmax(0, newNumChannels);
+			capacity = 2 * juce::jmax(1, maxColumns) + 2;
+			entries.assign((size_t)(numChannels * numLevels * capacity), {});
+			pending.assign((size_t)(numChannels * numLevels), {});
+			levelState.assign((size_t)numLevels, {});
+			samplesInBlock = 0;
+		}
+
+		int getNumChannels() const noexcept { return numChannels; }
+
+		void clear() noexcept {
+			std::fill(entries.begin(), entries.end(), juce::Range<float>());
+			std::fill(pending.begin(), pending.end(), Pending());
+			std::fill(levelState.begin(), levelState.end(), LevelState());
+			samplesInBlock = 0;
+		}
+
+		/* adds numSamples samples of every channel (missing channels are treated as silence) */
+		void push(const float* const* channelData, int numChannelsToPush, int numSamples) noexcept {
+			if (numChannels == 0)
+				return;
+
+			int i = 0;
+			while (i < numSamples) {
+				auto runLength = juce::jmin(baseBlockSize - samplesInBlock, numSamples - i);
+
+				for (int channel = 0; channel < numChannels; ++channel) {
+					auto& p = pending[(size_t)(channel * numLevels)];
+					if (channel < numChannelsToPush) {
+						auto range = juce::FloatVectorOperations::findMinAndMax(channelData[channel] + i, runLength);
+						p.range = p.count == 0 ? range : p.range.getUnionWith(range);
+					}
+					else if (p.count == 0) {
+						p.range = {};
+					}
+					p.count = 1; // level 0 only tracks whether the block has started
+				}
+
+				samplesInBlock += runLength;
+				i += runLength;
+
+				if (samplesInBlock == baseBlockSize) {
+					samplesInBlock = 0;
+					completeEntry(0);
+				}
+			}
+		}
+
+		/* columns are numbered from the start of the history at a fixed samplesPerColumn (clamped to {baseBlockSize, maxBlockSize}), so a
+		scrolling view can ask for just the ones that completed since it last drew. Returns how many columns are complete */
+		juce::int64 getNumColumns(double samplesPerColumn) const noexcept {
+			auto level = getLevel(samplesPerColumn);
+			return (juce::int64)std::floor((double)levelState[(size_t)level].numWritten / getEntriesPerColumn(samplesPerColumn, level));
+		}
+
+		/* fills numColumns ranges, starting at column firstColumn. Columns outside the stored history are left empty */
+		void getColumns(int channel, double samplesPerColumn, juce::int64 firstColumn, juce::Range<float>* destination, int numColumns) const noexcept {
+			jassert(channel < numChannels);
+			auto level = getLevel(samplesPerColumn);
+			auto entriesPerColumn = getEntriesPerColumn(samplesPerColumn, level); // in {1.0, 2.0}
+			auto numWritten = levelState[(size_t)level].numWritten;
+			auto oldestStored = juce::jmax((juce::int64)0, numWritten - capacity);
+			const auto* ring = entries.data() + (size_t)((channel * numLevels + level) * capacity);
+
+			for (int i = 0; i < numColumns; ++i) {
+				// column k covers entries [floor(k * entriesPerColumn), floor((k + 1) * entriesPerColumn))
+				auto column = firstColumn + i;
+				auto first = juce::jmax(oldestStored, (juce::int64)std::floor((double)column * entriesPerColumn));
+				auto last = juce::jmin(numWritten, (juce::int64)std::floor((double)(column + 1) * entriesPerColumn));
+
+				juce::Range<float> range;
+				for (auto entry = first; entry < last; ++entry) {
+					auto& value = ring[(size_t)(entry % capacity)];
+					range = entry == first ? value : range.getUnionWith(value);
+				}
+				destination[i] = range;
+			}
+		}
+
+		/* the newest numColumns complete columns, oldest first */
+		void getColumns(int channel, double samplesPerColumn, juce::Range<float>* destination, int numColumns) const noexcept {
+			getColumns(channel, samplesPerColumn, getNumColumns(samplesPerColumn) - numColumns, destination, numColumns);
+		}
+
+	private:
+		struct Pending {
+			juce::Range<float> range;
+			int count = 0;
+		};
+
+		struct LevelState {
+			juce::int64 numWritten = 0; // since the last clear(); entry n lives at n % capacity in the ring, which holds the newest capacity entries
+		};
+
+		int numChannels = 0, capacity = 0;
+		std::vector<juce::Range<float>> entries; // [channel][level][capacity]
+		std::vector<Pending> pending; // [channel][level], the entry being built
+		std::vector<LevelState> levelState; // shared by every channel, which always advance together
+		int samplesInBlock = 0;
+
+		static int getLevel(double samplesPerColumn) noexcept {
+			samplesPerColumn = juce::jlimit((double)baseBlockSize, (double)maxBlockSize, samplesPerColumn);
+			return juce::jlimit(0, numLevels - 1, (int)std::floor(std::log2(samplesPerColumn / (double)baseBlockSize)));
+		}
+
+		static double getEntriesPerColumn(double samplesPerColumn, int level) noexcept {
+			return juce::jlimit((double)baseBlockSize, (double)maxBlockSize, samplesPerColumn) / (double)(baseBlockSize << level);
+		}
+
+		void completeEntry(int level) noexcept {
+			auto& state = levelState[(size_t)level];
+			for (int channel = 0; channel < numChannels; ++channel) {
+				auto& p = pending[(size_t)(channel * numLevels + level)];
+				auto entry = p.range;
+				entries[(size_t)((channel * numLevels + level) * capacity + state.numWritten % capacity)] = entry;
+				p = {};
+
+				if (level + 1 < numLevels) {
+					auto& parent = pending[(size_t)(channel * numLevels + level + 1)];
+					parent.range = parent.count == 0 ? entry : parent.range.getUnionWith(entry);
+					++parent.count;
+				}
+			}
+
+			++state.numWritten;
+
+			// every channel's parent has the same count, so channel 0 decides
+			if (level + 1 < numLevels && pending[(size_t)(level + 1)].count == 2)
+				completeEntry(level + 1);
+		}
+	};
+
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ThreadFunctions.h" // AudioSampleFifo, spin_lock
+
+namespace magna {
+
+	/* Runs windowed FFTs on a background thread and publishes one ready-to-draw array of log-frequency band levels per channel, so nothing
+	but copying samples in and levels out happens on the message thread.
+	Frames overlap by (fftSize - hop) samples. Each band is the peak bin magnitude within it (or the interpolated magnitude at its centre,
+	where bands are narrower than a bin), in dB mapped onto {0.0, 1.0} over {minDecibels, 0dB}. Levels rise instantly and fall at
+	decayDecibelsPerSecond; peaks hold for peakHoldSeconds before falling at the same rate.
+	With the frame history enabled, every frame's undecayed levels (the loudest channel per band) are also queued for a consumer that needs
+	all of them, such as a spectrogram */
+	class SpectrumAnalyser : private juce::Thread {
+	public:
+		struct Settings {
+			int fftOrder = 11;						// 2048-point FFT
+			int hop = 512;							// samples between frames
+			int numBands = 256;
+			float minFrequency = 20.0f, maxFrequency = 20000.0f;
+			float minDecibels = -90.0f;
+			float decayDecibelsPerSecond = 36.0f;
+			float peakHoldSeconds = 1.0f;
+		};
+
+		SpectrumAnalyser() : juce::Thread("Spectrum Analyser") {}
+		~SpectrumAnalyser() override { stopThread(1000); }
+
+		/* (re)starts the analysis thread. Call from the message thread */
+		void prepare(double newSampleRate, int newNumChannels, const Settings& newSettings = {}) {
+			stopThread(1000);
+
+			settings = newSettings;
+			settings.hop = juce::jlimit(1, 1 << settings.fftOrder, settings.hop);
+			sampleRate = newSampleRate;
+			numChannels = juce::jmax(1, newNumChannels);
+			fftSize = 1 << settings.fftOrder;
+
+			fft = std::make_unique<juce::dsp::FFT>(settings.fftOrder);
+			window = std::make_unique<juce::dsp::WindowingFunction<float>>((size_t)fftSize, juce::dsp::WindowingFunction<float>::hann, true);
+			input = std::make_unique<AudioSampleFifo>(numChannels, juce::jmax(fftSize * 4, (int)sampleRate / 2));
+			history.setSize(numChannels, fftSize);
+			history.clear();
+			hopBuffer.setSize(numChannels, settings.hop);
+			fftData.assign((size_t)fftSize * 2, 0.0f);
+			samplesUntilNextFrame = settings.hop;
+
+			computeBands();
+			levels.assign((size_t)(numChannels * settings.numBands), 0.0f);
+			peaks.assign((size_t)(numChannels * settings.numBands), 0.0f);
+			peakHoldRemaining.assign((size_t)(numChannels * settings.numBands), 0.0f);
+			{
+				std::lock_guard<spin_lock> lock(resultsLock);
+				publishedLevels = levels;
+				publishedPeaks = peaks;
+			}
+
+			// frame history: one "channel" per band, one "sample" per frame
+			auto wasEnabled = frames != nullptr && frames->isConsumerActive();
+			frames = std::make_unique<AudioSampleFifo>(settings.numBands, frameHistoryCapacity);
+			frames->setConsumerActive(wasEnabled);
+			frameLevels.assign((size_t)settings.numBands, 0.0f);
+			framePointers.resize((size_t)settings.numBands);
+			for (size_t band = 0; band < framePointers.size(); ++band)
+				framePointers[band] = frameLevels.data() + band;
+
+			startThread();
+		}
+
+		double getSampleRate() const noexcept { return sampleRate; }
+		int getNumChannels() const noexcept { return numChannels; }
+		const Settings& getSettings() const noexcept { return settings; }
+
+		/* frequency at the left edge of band (or at numBands for the right edge of the last one) */
+		float getBandFrequency(float band) const noexcept {
+			return settings.minFrequency * std::pow(settings.maxFrequency / settings.minFrequency, band / (float)settings.numBands);
+		}
+
+		/* producer side (one thread only, e.g. the message thread draining the processor's FIFO). Never blocks */
+		void push(const float* const* channelData, int numChannelsToPush, int numSamples) noexcept {
+			if (input == nullptr)
+				return;
+			input->push(channelData, juce::jmin(numChannelsToPush, numChannels), numSamples);
+			notify();
+		}
+
+		/* copies the latest levels and peaks (numChannels * numBands each, channel after channel) if they changed since the last call */
+		bool getLatestResults(std::vector<float>& levelsOut, std::vector<float>& peaksOut) {
+			if (!resultsChanged.exchange(false))
+				return false;
+			std::lock_guard<spin_lock> lock(resultsLock);
+			levelsOut = publishedLevels;
+			peaksOut = publishedPeaks;
+			return true;
+		}
+
+		/* frames are only queued while enabled, so nothing is spent on them when no one reads them */
+		void setFrameHistoryEnabled(bool shouldBeEnabled) noexcept {
+			if (frames != nullptr)
+				frames->setConsumerActive(shouldBeEnabled);
+		}
+
+		/* consumer side (one thread only): reads queued frames into destination, band n of each frame into channel n (destination needs
+		numBands channels), one frame per sample. Returns how many frames. Frames that arrive while the queue is full are dropped */
+		int popFrames(juce::AudioBuffer<float>& destination) noexcept {
+			return frames != nullptr ? frames->pop(destination) : 0;
+		}
+
+	private:
+		static constexpr int frameHistoryCapacity = 256;
+
+		Settings settings;
+		double sampleRate = 44100.0;
+		int numChannels = 1, fftSize = 2048;
+
+		std::unique_ptr<juce::dsp::FFT> fft;
+		std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+		std::unique_ptr<AudioSampleFifo> input;
+
+		juce::AudioBuffer<float> history, hopBuffer; // history holds the last fftSize samples of every channel, oldest first
+		std::vector<float> fftData;
+		int samplesUntilNextFrame = 0;
+
+		// per band: first and one-past-last FFT bin, and the (fractional) centre bin for bands narrower than a bin
+		std::vector<int> bandStartBin, bandEndBin;
+		std::vector<float> bandCentreBin;
+
+		// only touched by the analysis thread
+		std::vector<float> levels, peaks, peakHoldRemaining;
+
+		spin_lock resultsLock;
+		std::vector<float> publishedLevels, publishedPeaks;
+		std::atomic<bool> resultsChanged{ false };
+
+		std::unique_ptr<AudioSampleFifo> frames;
+		std::vector<float> frameLevels; // the frame being queued
+		std::vector<const float*> framePointers; // into frameLevels, one per band
+
+		void computeBands() {
+			auto binWidth = (float)sampleRate / (float)fftSize;
+			auto nyquistBin = fftSize / 2;
+			bandStartBin.resize((size_t)settings.numBands);
+			bandEndBin.resize((size_t)settings.numBands);
+			bandCentreBin.resize((size_t)settings.numBands);
+
+			for (int band = 0; band < settings.numBands; ++band) {
+				auto low = getBandFrequency((float)band) / binWidth;
+				auto high = getBandFrequency((float)(band + 1)) / binWidth;
+				bandStartBin[(size_t)band] = juce::jlimit(0, nyquistBin, (int)std::ceil(low));
+				bandEndBin[(size_t)band] = juce::jlimit(0, nyquistBin + 1, (int)std::ceil(high));
+				bandCentreBin[(size_t)band] = juce::jlimit(0.0f, (float)nyquistBin, std::sqrt(low * high));
+			}
+		}
+
+		void run() override {
+			while (!threadShouldExit()) {
+				wait(100);
+
+				// hops are read whole, so a frame is taken exactly every hop samples
+				while (!threadShouldExit()) {
+					auto numRead = readHop();
+					if (numRead == 0)
+						break;
+
+					samplesUntilNextFrame -= numRead;
+					if (samplesUntilNextFrame <= 0) {
+						analyseFrame();
+						samplesUntilNextFrame += settings.hop;
+					}
+				}
+			}
+		}
+
+		/* moves up to samplesUntilNextFrame new samples onto the end of the history */
+		int readHop() {
+			hopBuffer.setSize(numChannels, samplesUntilNextFrame, false, false, true);
+			auto numRead = input->pop(hopBuffer);
+			if (numRead == 0)
+				return 0;
+
+			for (int channel = 0; channel < numChannels; ++channel) {
+				auto* data = history.getWritePointer(channel);
+				std::memmove(data, data + numRead, sizeof(float) * (size_t)(fftSize - numRead));
+				std::memcpy(data + fftSize - numRead, hopBuffer.getReadPointer(channel), sizeof(float) * (size_t)numRead);
+			}
+			return numRead;
+		}
+
+		void analyseFrame() {
+			auto seconds = (float)settings.hop / (float)sampleRate;
+			auto decay = settings.decayDecibelsPerSecond * seconds / -settings.minDecibels; // in the normalised {0.0, 1.0} range
+			auto magnitudeScale = 2.0f / (float)fftSize;
+			std::fill(frameLevels.begin(), frameLevels.end(), 0.0f);
+
+			for (int channel = 0; channel < numChannels; ++channel) {
+				std::copy(history.getReadPointer(channel), history.getReadPointer(channel) + fftSize, fftData.begin());
+				std::fill(fftData.begin() + fftSize, fftData.end(), 0.0f);
+				window->multiplyWithWindowingTable(fftData.data(), (size_t)fftSize);
+				fft->performFrequencyOnlyForwardTransform(fftData.data());
+
+				auto* channelLevels = levels.data() + channel * settings.numBands;
+				auto* channelPeaks = peaks.data() + channel * settings.numBands;
+				auto* channelHold = peakHoldRemaining.data() + channel * settings.numBands;
+
+				for (int band = 0; band < settings.numBands; ++band) {
+					float magnitude = 0.0f;
+					if (bandEndBin[(size_t)band] > bandStartBin[(size_t)band]) {
+						for (int bin = bandStartBin[(size_t)band]; bin < bandEndBin[(size_t)band]; ++bin)
+							magnitude = juce::jmax(magnitude, fftData[(size_t)bin]);
+					}
+					else {
+						auto centre = bandCentreBin[(size_t)band];
+						auto bin = juce::jmin((int)centre, fftSize / 2 - 1);
+						magnitude = fftData[(size_t)bin] + (centre - (float)bin) * (fftData[(size_t)bin + 1] - fftData[(size_t)bin]);
+					}
+
+					auto decibels = juce::Decibels::gainToDecibels(magnitude * magnitudeScale, settings.minDecibels);
+					auto level = juce::jmap(decibels, settings.minDecibels, 0.0f, 0.0f, 1.0f);
+
+					channelLevels[band] = juce::jmax(level, channelLevels[band] - decay);
+					frameLevels[(size_t)band] = juce::jmax(frameLevels[(size_t)band], level);
+
+					if (level >= channelPeaks[band]) {
+						channelPeaks[band] = level;
+						channelHold[band] = settings.peakHoldSeconds;
+					}
+					else if (channelHold[band] > 0.0f) {
+						channelHold[band] -= seconds;
+					}
+					else {
+						channelPeaks[band] = juce::jmax(channelLevels[band], channelPeaks[band] - decay);
+					}
+				}
+			}
+
+			{
+				std::lock_guard<spin_lock> lock(resultsLock);
+				std::copy(levels.begin(), levels.end(), publishedLevels.begin());
+				std::copy(peaks.begin(), peaks.end(), publishedPeaks.begin());
+			}
+			resultsChanged = true;
+
+			if (frames->isConsumerActive())
+				frames->push(framePointers.data(), settings.numBands, 1);
+		}
+
+		JUCE_DECLARE_NON_COPYABLE(SpectrumAnalyser)
+	};
+
+}
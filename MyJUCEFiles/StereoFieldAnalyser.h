@@ -0,0 +1,126 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "ThreadFunctions.h" // AudioSampleFifo
+
+namespace magna {
+
+	/* Measures a stereo pair on a background thread: mid/side points for a goniometer, the correlation coefficient ({-1.0, 1.0}, 1.0 = mono,
+	0.0 = unrelated, -1.0 = out of phase) and the balance ({-1.0, 1.0}, left to right, by power).
+	Every block is swept once with SIMD registers, which produce the mid and side samples and the L*L, R*R and L*R sums together; the sums are
+	then averaged over integrationSeconds so the meters read steadily. The message thread only pushes samples in and reads results out */
+	class StereoFieldAnalyser : private juce::Thread {
+	public:
+		StereoFieldAnalyser() : juce::Thread("Stereo Field Analyser") {}
+		~StereoFieldAnalyser() override { stopThread(1000); }
+
+		/* (re)starts the analysis thread. Call from the message thread */
+		void prepare(double sampleRate, float integrationSeconds = 0.3f) {
+			stopThread(1000);
+
+			blockCoefficient = 1.0f - std::exp(-(float)blockSize / (integrationSeconds * (float)sampleRate));
+			input = std::make_unique<AudioSampleFifo>(2, juce::jmax(blockSize * 8, (int)sampleRate / 2));
+			points = std::make_unique<AudioSampleFifo>(2, juce::jmax(blockSize * 8, (int)sampleRate / 2));
+
+			// left, right, side, mid; SIMD-aligned
+			block = juce::dsp::AudioBlock<float>(blockMemory, 4, (size_t)blockSize);
+			block.clear();
+			float* inputChannels[] = { block.getChannelPointer(0), block.getChannelPointer(1) };
+			inputBuffer.setDataToReferTo(inputChannels, 2, blockSize);
+
+			meanLeftSquared = meanRightSquared = meanProduct = 0.0f;
+			correlation = 1.0f;
+			balance = 0.0f;
+
+			startThread();
+		}
+
+		/* producer side (one thread only). Never blocks */
+		void push(const float* left, const float* right, int numSamples) noexcept {
+			if (input == nullptr)
+				return;
+			const float* channels[] = { left, right };
+			input->push(channels, 2, numSamples);
+			notify();
+		}
+
+		/* consumer side (one thread only): side samples go into channel 0 of destination, mid samples into channel 1. Returns how many */
+		int popPoints(juce::AudioBuffer<float>& destination) noexcept {
+			return points != nullptr ? points->pop(destination) : 0;
+		}
+
+		float getCorrelation() const noexcept { return correlation.load(std::memory_order_relaxed); }
+		float getBalance() const noexcept { return balance.load(std::memory_order_relaxed); }
+
+	private:
+		static constexpr int blockSize = 512;
+
+		std::unique_ptr<AudioSampleFifo> input, points;
+		juce::HeapBlock<char> blockMemory;
+		juce::dsp::AudioBlock<float> block;
+		juce::AudioBuffer<float> inputBuffer; // refers to the first two channels of block
+
+		float blockCoefficient = 0.0f;
+		float meanLeftSquared = 0.0f, meanRightSquared = 0.0f, meanProduct = 0.0f;
+		std::atomic<float> correlation{ 1.0f }, balance{ 0.0f };
+
+		void run() override {
+			while (!threadShouldExit()) {
+				wait(100);
+
+				for (int numRead = input->pop(inputBuffer); numRead > 0 && !threadShouldExit(); numRead = input->pop(inputBuffer))
+					analyseBlock(numRead);
+			}
+		}
+
+		void analyseBlock(int numSamples) noexcept {
+			using SIMD = juce::dsp::SIMDRegister<float>;
+			const auto* left = block.getChannelPointer(0);
+			const auto* right = block.getChannelPointer(1);
+			auto* side = block.getChannelPointer(2);
+			auto* mid = block.getChannelPointer(3);
+			const auto scale = juce::MathConstants<float>::sqrt2 * 0.5f;
+
+			auto leftSquared = SIMD::expand(0.0f), rightSquared = SIMD::expand(0.0f), product = SIMD::expand(0.0f);
+			auto numVectorised = numSamples - numSamples % (int)SIMD::size();
+			for (int i = 0; i < numVectorised; i += (int)SIMD::size()) {
+				auto l = SIMD::fromRawArray(left + i);
+				auto r = SIMD::fromRawArray(right + i);
+				leftSquared += l * l;
+				rightSquared += r * r;
+				product += l * r;
+				((l - r) * scale).copyToRawArray(side + i);
+				((l + r) * scale).copyToRawArray(mid + i);
+			}
+
+			auto sumLeftSquared = leftSquared.sum(), sumRightSquared = rightSquared.sum(), sumProduct = product.sum();
+			for (int i = numVectorised; i < numSamples; ++i) {
+				sumLeftSquared += left[i] * left[i];
+				sumRightSquared += right[i] * right[i];
+				sumProduct += left[i] * right[i];
+				side[i] = (left[i] - right[i]) * scale;
+				mid[i] = (left[i] + right[i]) * scale;
+			}
+
+			const float* pointChannels[] = { side, mid };
+			points->push(pointChannels, 2, numSamples);
+
+			// one-pole averages, weighted by how much of a full block this was
+			auto coefficient = blockCoefficient * (float)numSamples / (float)blockSize;
+			auto n = (float)numSamples;
+			meanLeftSquared += coefficient * (sumLeftSquared / n - meanLeftSquared);
+			meanRightSquared += coefficient * (sumRightSquared / n - meanRightSquared);
+			meanProduct += coefficient * (sumProduct / n - meanProduct);
+
+			// silence reads as mono and centred rather than jumping around
+			const auto silence = 1.0e-10f;
+			auto power = meanLeftSquared * meanRightSquared;
+			correlation.store(power > silence * silence ? juce::jlimit(-1.0f, 1.0f, meanProduct / std::sqrt(power)) : 1.0f, std::memory_order_relaxed);
+			auto total = meanLeftSquared + meanRightSquared;
+			balance.store(total > silence ? (meanRightSquared - meanLeftSquared) / total : 0.0f, std::memory_order_relaxed);
+		}
+
+		JUCE_DECLARE_NON_COPYABLE(StereoFieldAnalyser)
+	};
+
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <JuceHeader.h>
 #include <atomic>
+#include <cstdlib>
+#include <new>
 
 // source: https://www.youtube.com/watch?v=Q0vrQFyAdWI&t=130s&ab_channel=JUCE
 class spin_lock {
@@ -19,4 +22,115 @@ public:
 
 private:
 	std::atomic_flag flag = ATOMIC_FLAG_INIT;
-};
\ No newline at end of file
+};
+namespace magna {
+
+	/* Single-producer/single-consumer FIFO of multichannel audio built on juce::AbstractFifo: the audio thread pushes, a GUI timer pops, and
+	neither side ever locks or allocates. The storage is sized once, for the most channels the producer will ever push.
+	When the consumer falls behind, whole pushes are dropped (and counted) instead of written in part, so every block that does arrive is complete */
+	class AudioSampleFifo {
+	public:
+		AudioSampleFifo(int maxChannels, int capacity) : fifo(capacity), buffer(maxChannels, capacity) {
+			buffer.clear();
+		}
+
+		int getMaxChannels() const noexcept { return buffer.getNumChannels(); }
+		/* channel count of the most recent push */
+		int getNumChannels() const noexcept { return numChannels.load(std::memory_order_acquire); }
+
+		/* producer only. Returns false (and counts a drop) if there isn't room for all numSamples samples */
+		bool push(const float* const* channelData, int numChannelsToPush, int numSamples) noexcept {
+			numChannelsToPush = juce::jmin(numChannelsToPush, getMaxChannels());
+			if (numChannelsToPush != numChannels.load(std::memory_order_relaxed))
+				numChannels.store(numChannelsToPush, std::memory_order_release);
+
+			if (fifo.getFreeSpace() < numSamples) {
+				numDropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+
+			int start1, size1, start2, size2;
+			fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+			for (int channel = 0; channel < numChannelsToPush; ++channel) {
+				if (size1 > 0)
+					buffer.copyFrom(channel, start1, channelData[channel], size1);
+				if (size2 > 0)
+					buffer.copyFrom(channel, start2, channelData[channel] + size1, size2);
+			}
+			fifo.finishedWrite(size1 + size2);
+			return true;
+		}
+
+		/* consumer only. Reads up to destination.getNumSamples() samples into the first min(channels) channels of destination; returns how many */
+		int pop(juce::AudioBuffer<float>& destination) noexcept {
+			auto channelsToRead = juce::jmin(destination.getNumChannels(), getNumChannels());
+			int start1, size1, start2, size2;
+			fifo.prepareToRead(destination.getNumSamples(), start1, size1, start2, size2);
+			for (int channel = 0; channel < channelsToRead; ++channel) {
+				if (size1 > 0)
+					destination.copyFrom(channel, 0, buffer, channel, start1, size1);
+				if (size2 > 0)
+					destination.copyFrom(channel, size1, buffer, channel, start2, size2);
+			}
+			fifo.finishedRead(size1 + size2);
+			return size1 + size2;
+		}
+
+		/* consumer only: throws away everything waiting, e.g. stale audio from before the consumer attached */
+		void discard() noexcept { fifo.finishedRead(fifo.getNumReady()); }
+
+		int getNumDropped() const noexcept { return numDropped.load(std::memory_order_relaxed); }
+
+		/* the producer can skip pushing entirely while nothing is reading */
+		void setConsumerActive(bool isActive) noexcept { consumerActive.store(isActive, std::memory_order_release); }
+		bool isConsumerActive() const noexcept { return consumerActive.load(std::memory_order_acquire); }
+
+	private:
+		juce::AbstractFifo fifo;
+		juce::AudioBuffer<float> buffer;
+		std::atomic<int> numChannels{ 0 }, numDropped{ 0 };
+		std::atomic<bool> consumerActive{ false };
+
+		JUCE_DECLARE_NON_COPYABLE(AudioSampleFifo)
+	};
+
+	/* Counts heap allocations made by a thread while it is inside an AllocationCounter::Scope (e.g. the whole of processBlock()), to catch
+	allocations on the audio thread. The counting only happens if MAGNA_DEFINE_COUNTING_OPERATOR_NEW is expanded in exactly one .cpp file of
+	the project (it replaces the global operator new/delete); without it getCount() always returns 0 */
+	class AllocationCounter {
+	public:
+		class Scope {
+		public:
+			Scope() noexcept : wasCounting(isCounting()) { isCounting() = true; }
+			~Scope() noexcept { isCounting() = wasCounting; }
+		private:
+			bool wasCounting;
+		};
+
+		static int getCount() noexcept { return count().load(std::memory_order_relaxed); }
+		static void reset() noexcept { count().store(0, std::memory_order_relaxed); }
+
+		static void noteAllocation() noexcept {
+			if (isCounting())
+				count().fetch_add(1, std::memory_order_relaxed);
+		}
+
+	private:
+		static std::atomic<int>& count() noexcept { static std::atomic<int> allocations{ 0 }; return allocations; }
+		static bool& isCounting() noexcept { thread_local bool counting = false; return counting; }
+	};
+
+}
+
+#define MAGNA_DEFINE_COUNTING_OPERATOR_NEW \
+	void* operator new(std::size_t size) { \
+		magna::AllocationCounter::noteAllocation(); \
+		if (auto* p = std::malloc(size > 0 ? size : 1)) \
+			return p; \
+		throw std::bad_alloc(); \
+	} \
+	void* operator new[](std::size_t size) { return operator new(size); } \
+	void operator delete(void* p) noexcept { std::free(p); } \
+	void operator delete[](void* p) noexcept { std::free(p); } \
+	void operator delete(void* p, std::size_t) noexcept { std::free(p); } \
+	void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
@@ -0,0 +1,609 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AnalogCircuits.h"
+
+#include <complex>
+#include <map>
+#include <memory>
+
+namespace magna {
+
+	/* WAVE DIGITAL LADDER FILTERS */
+
+	/* Doubly terminated RLC ladders described as data instead of as wdf:: template trees: a LadderNetlist (text, or generated by LadderDesign
+	from a Butterworth, Chebyshev or Bessel prototype) is compiled into a LadderTopology, a flat list of adaptors in the order the waves
+	visit them. Topologies hold no component values, so every ladder with the same shape shares one, built once and cached by a hash of the
+	shape. A LadderCircuit runs a topology with its own values and state */
+	namespace wdf {
+
+		/* A ladder as text, one line per termination or branch, from the source to the load ('#' starts a comment):
+			source 600			source resistance in ohms
+			series L 95.49m		a branch in the signal path; its parts are in series with each other
+			shunt C 530.5n		a branch from the signal path to ground; its parts are in parallel with each other
+			series L 1m C 2u	e.g. a series resonator
+			load 600			load resistance; the output is the voltage across it
+		Parts are R, L or C, in ohms, henries and farads, with an optional p, n, u, m, k or M suffix */
+		struct LadderNetlist {
+			struct Part {
+				char kind = 'R'; // 'R', 'L' or 'C'
+				double value = 1.0;
+			};
+
+			struct Branch {
+				bool shunt = false;
+				std::vector<Part> parts;
+			};
+
+			double sourceResistance = 1.0, loadResistance = 1.0;
+			std::vector<Branch> branches;
+
+			juce::Result parse(const juce::String& text) {
+				LadderNetlist parsed;
+				bool hasSource = false, hasLoad = false;
+				auto lines = juce::StringArray::fromLines(text);
+
+				for (int lineIndex = 0; lineIndex < lines.size(); ++lineIndex) {
+					auto line = lines[lineIndex].upToFirstOccurrenceOf("#", false, false).trim();
+					if (line.isEmpty())
+						continue;
+
+					auto error = [lineIndex](const juce::String& message) { return juce::Result::fail("line " + juce::String(lineIndex + 1) + ": " + message); };
+					auto tokens = juce::StringArray::fromTokens(line, " \t", {});
+					tokens.removeEmptyStrings();
+					auto keyword = tokens[0].toLowerCase();
+
+					if (keyword == "source" || keyword == "load") {
+						double resistance = 0.0;
+						if (tokens.size() != 2 || !parseValue(tokens[1], resistance))
+							return error(keyword + " needs one resistance");
+						if (hasLoad)
+							return error("nothing can follow the load");
+						if (keyword == "source") {
+							if (hasSource || !parsed.branches.empty())
+								return error("the source comes first, once");
+							parsed.sourceResistance = resistance;
+							hasSource = true;
+						}
+						else {
+							parsed.loadResistance = resistance;
+							hasLoad = true;
+						}
+					}
+					else if (keyword == "series" || keyword == "shunt") {
+						if (!hasSource || hasLoad)
+							return error("branches go between the source and the load");
+						if (tokens.size() < 3 || tokens.size() % 2 == 0)
+							return error(keyword + " needs one or more parts, each a kind and a value");
+
+						Branch branch;
+						branch.shunt = keyword == "shunt";
+						for (int i = 1; i < tokens.size(); i += 2) {
+							Part part;
+							part.kind = (char)tokens[i].toUpperCase()[0];
+							if (tokens[i].length() != 1 || (part.kind != 'R' && part.kind != 'L' && part.kind != 'C'))
+								return error("unknown part " + tokens[i] + ", expected R, L or C");
+							if (!parseValue(tokens[i + 1], part.value))
+								return error("bad value " + tokens[i + 1]);
+							branch.parts.push_back(part);
+						}
+						parsed.branches.push_back(std::move(branch));
+					}
+					else {
+						return error("unknown line " + tokens[0] + ", expected source, series, shunt or load");
+					}
+				}
+
+				if (!hasSource || !hasLoad)
+					return juce::Result::fail("a ladder needs a source and a load");
+				*this = std::move(parsed);
+				return juce::Result::ok();
+			}
+
+			juce::String toString() const {
+				juce::String text;
+				text << "source " << juce::String(sourceResistance, 6, true) << juce::newLine;
+				for (auto& branch : branches) {
+					text << (branch.shunt ? "shunt" : "series");
+					for (auto& part : branch.parts)
+						text << " " << juce::String::charToString((juce::juce_wchar)part.kind) << " " << juce::String(part.value, 6, true);
+					text << juce::newLine;
+				}
+				text << "load " << juce::String(loadResistance, 6, true) << juce::newLine;
+				return text;
+			}
+
+			/* the shape without the values: what LadderTopology is cached by */
+			juce::String getTopologyKey() const {
+				juce::String key;
+				for (auto& branch : branches) {
+					key << (branch.shunt ? 'P' : 'S');
+					for (auto& part : branch.parts)
+						key << juce::String::charToString((juce::juce_wchar)part.kind);
+					key << '|';
+				}
+				return key;
+			}
+
+		private:
+			static bool parseValue(const juce::String& token, double& value) {
+				auto text = token.toStdString();
+				char* end = nullptr;
+				value = std::strtod(text.c_str(), &end);
+				if (end == text.c_str())
+					return false;
+
+				juce::String suffix(end);
+				if (suffix == "p")			value *= 1.0e-12;
+				else if (suffix == "n")		value *= 1.0e-9;
+				else if (suffix == "u")		value *= 1.0e-6;
+				else if (suffix == "m")		value *= 1.0e-3;
+				else if (suffix == "k")		value *= 1.0e3;
+				else if (suffix == "M")		value *= 1.0e6;
+				else if (suffix.isNotEmpty())	return false;
+				return value > 0.0 && std::isfinite(value);
+			}
+		};
+
+		/* A ladder's adaptor tree, flattened: the load at the bottom, each branch joined to what is below it by a series or parallel 3-port,
+		and the top node facing the source. Nodes are in post-order (children before parents), so one forward pass gathers the reflected
+		waves and one backward pass scatters the incident ones, with no recursion or pointers. Parts are numbered in netlist order, the load
+		last. Immutable and shared: get() returns the cached topology for a netlist's shape */
+		class LadderTopology {
+		public:
+			enum class Kind : juce::uint8 { resistor, capacitor, inductor, series, parallel };
+
+			struct Node {
+				Kind kind = Kind::resistor;
+				int left = -1, right = -1;	// adaptors
+				int part = -1;				// leaves
+			};
+
+			/* builds the topology the first time a shape is seen. Locks and may allocate, so not on the audio thread */
+			static std::shared_ptr<const LadderTopology> get(const LadderNetlist& netlist) {
+				auto key = netlist.getTopologyKey();
+				auto hash = hashKey(key);
+
+				static juce::CriticalSection lock;
+				static std::multimap<juce::uint64, std::shared_ptr<const LadderTopology>> cache;
+				const juce::ScopedLock scopedLock(lock);
+
+				for (auto range = cache.equal_range(hash); range.first != range.second; ++range.first)
+					if (range.first->second->key == key)
+						return range.first->second;
+
+				auto topology = std::shared_ptr<LadderTopology>(new LadderTopology(netlist, key));
+				cache.emplace(hash, topology);
+				return topology;
+			}
+
+			const std::vector<Node>& getNodes() const noexcept { return nodes; }
+			int getTopNode() const noexcept { return (int)nodes.size() - 1; }
+			int getLoadNode() const noexcept { return loadNode; }
+			int getNumParts() const noexcept { return numParts; }
+
+		private:
+			juce::String key;
+			std::vector<Node> nodes;
+			int loadNode = 0, numParts = 0;
+
+			LadderTopology(const LadderNetlist& netlist, const juce::String& newKey) : key(newKey) {
+				for (auto& branch : netlist.branches)
+					numParts += (int)branch.parts.size();
+				++numParts; // the load
+
+				// the load first, then each branch from the last to the first, joined to everything below it
+				loadNode = addLeaf('R', numParts - 1);
+				auto below = loadNode;
+				auto part = numParts - 1;
+				for (auto branch = netlist.branches.rbegin(); branch != netlist.branches.rend(); ++branch) {
+					part -= (int)branch->parts.size();
+					auto joint = branch->shunt ? Kind::parallel : Kind::series;
+
+					// a series branch's parts are in series, a shunt branch's in parallel
+					auto top = addLeaf(branch->parts[0].kind, part);
+					for (size_t i = 1; i < branch->parts.size(); ++i)
+						top = addAdaptor(joint, top, addLeaf(branch->parts[i].kind, part + (int)i));
+					below = addAdaptor(joint, top, below);
+				}
+			}
+
+			int addLeaf(char kind, int part) {
+				Node node;
+				node.kind = kind == 'L' ? Kind::inductor : kind == 'C' ? Kind::capacitor : Kind::resistor;
+				node.part = part;
+				nodes.push_back(node);
+				return (int)nodes.size() - 1;
+			}
+
+			int addAdaptor(Kind kind, int left, int right) {
+				Node node;
+				node.kind = kind;
+				node.left = left;
+				node.right = right;
+				nodes.push_back(node);
+				return (int)nodes.size() - 1;
+			}
+
+			/* FNV-1a */
+			static juce::uint64 hashKey(const juce::String& key) noexcept {
+				juce::uint64 hash = 14695981039346656037ull;
+				for (auto* character = key.toRawUTF8(); *character != 0; ++character) {
+					hash ^= (juce::uint64)(unsigned char)*character;
+					hash *= 1099511628211ull;
+				}
+				return hash;
+			}
+		};
+
+		/* A LadderTopology with component values, coefficients and state, driven by a resistive source. Like the template circuits it runs
+		one ladder per lane and keeps reactive state in State (see Precision). prepare() allocates; retune by preparing again, which reuses
+		the cached topology */
+		template <typename Lane, template <typename> class State = LaneState>
+		class LadderCircuit {
+		public:
+			using Kind = LadderTopology::Kind;
+
+			void prepare(const LadderNetlist& netlist, double sampleRate) {
+				topology = LadderTopology::get(netlist);
+				auto numNodes = topology->getNodes().size();
+
+				sourceResistance = netlist.sourceResistance;
+				values.clear();
+				for (auto& branch : netlist.branches)
+					for (auto& part : branch.parts)
+						values.push_back(part.value);
+				values.push_back(netlist.loadResistance);
+
+				portResistance.assign(numNodes, 1.0);
+				leftShare.assign(numNodes, zero<Lane>());
+				rightShare.assign(numNodes, zero<Lane>());
+				up.assign(numNodes, zero<Lane>());
+				down.assign(numNodes, zero<Lane>());
+				state.assign(numNodes, {});
+
+				update(sampleRate);
+				reset();
+			}
+
+			bool isPrepared() const noexcept { return topology != nullptr; }
+
+			/* port resistances bottom-up, then the source's reflection */
+			void update(double sampleRate) noexcept {
+				const auto& nodes = topology->getNodes();
+				for (size_t i = 0; i < nodes.size(); ++i) {
+					auto& node = nodes[i];
+					switch (node.kind) {
+					case Kind::resistor:	portResistance[i] = values[(size_t)node.part]; break;
+					case Kind::capacitor:	portResistance[i] = 1.0 / (2.0 * values[(size_t)node.part] * sampleRate); break;
+					case Kind::inductor:	portResistance[i] = 2.0 * values[(size_t)node.part] * sampleRate; break;
+					case Kind::series: {
+						auto left = portResistance[(size_t)node.left], right = portResistance[(size_t)node.right];
+						portResistance[i] = left + right;
+						leftShare[i] = LaneTraits<Lane>::expand(left / portResistance[i]);
+						rightShare[i] = LaneTraits<Lane>::expand(right / portResistance[i]);
+						break;
+					}
+					case Kind::parallel: {
+						auto left = 1.0 / portResistance[(size_t)node.left], right = 1.0 / portResistance[(size_t)node.right];
+						portResistance[i] = 1.0 / (left + right);
+						leftShare[i] = LaneTraits<Lane>::expand(left * portResistance[i]);
+						rightShare[i] = LaneTraits<Lane>::expand(right * portResistance[i]);
+						break;
+					}
+					}
+				}
+
+				auto R = portResistance.back();
+				reflection = LaneTraits<Lane>::expand((sourceResistance - R) / (sourceResistance + R));
+				gain = LaneTraits<Lane>::expand(2.0 * R / (sourceResistance + R));
+			}
+
+			void reset() noexcept {
+				for (auto& s : state)
+					s.store(zero<Lane>());
+				std::fill(up.begin(), up.end(), zero<Lane>());
+				std::fill(down.begin(), down.end(), zero<Lane>());
+			}
+
+			/* returns the voltage across the load */
+			Lane process(Lane x) noexcept {
+				const auto* nodes = topology->getNodes().data();
+				auto numNodes = (int)topology->getNodes().size();
+
+				// resistors (adapted) reflect nothing, so their up[] stays zero
+				for (int i = 0; i < numNodes; ++i) {
+					auto& node = nodes[i];
+					switch (node.kind) {
+					case Kind::resistor:	break;
+					case Kind::capacitor:
+					case Kind::inductor:	up[(size_t)i] = state[(size_t)i].load(); break;
+					case Kind::series:		up[(size_t)i] = zero<Lane>() - (up[(size_t)node.left] + up[(size_t)node.right]); break;
+					case Kind::parallel:	up[(size_t)i] = leftShare[(size_t)i] * up[(size_t)node.left] + rightShare[(size_t)i] * up[(size_t)node.right]; break;
+					}
+				}
+
+				down[(size_t)(numNodes - 1)] = reflection * up[(size_t)(numNodes - 1)] + gain * x;
+
+				for (int i = numNodes - 1; i >= 0; --i) {
+					auto& node = nodes[i];
+					auto a = down[(size_t)i];
+					switch (node.kind) {
+					case Kind::resistor:	break;
+					case Kind::capacitor:	state[(size_t)i].store(a); break;
+					case Kind::inductor:	state[(size_t)i].store(zero<Lane>() - a); break;
+					case Kind::series: {
+						auto left = up[(size_t)node.left], right = up[(size_t)node.right];
+						auto sum = a + left + right;
+						down[(size_t)node.left] = left - leftShare[(size_t)i] * sum;
+						down[(size_t)node.right] = right - rightShare[(size_t)i] * sum;
+						break;
+					}
+					case Kind::parallel: {
+						auto junction = a + up[(size_t)i];
+						down[(size_t)node.left] = junction - up[(size_t)node.left];
+						down[(size_t)node.right] = junction - up[(size_t)node.right];
+						break;
+					}
+					}
+				}
+
+				return down[(size_t)topology->getLoadNode()] * LaneTraits<Lane>::expand(0.5);
+			}
+
+		private:
+			std::shared_ptr<const LadderTopology> topology;
+			double sourceResistance = 1.0;
+			std::vector<double> values, portResistance; // values by part, port resistances by node
+			std::vector<Lane> leftShare, rightShare;	// adaptors
+			std::vector<Lane> up, down;					// the waves towards the source and towards the load, by node
+			std::vector<State<Lane>> state;				// reactive leaves
+			Lane reflection = zero<Lane>(), gain = zero<Lane>();
+		};
+
+		/* Netlists for the classic doubly terminated ladders, from the normalised lowpass prototype (1 ohm, 1 rad/s, series L first):
+		- Butterworth and Chebyshev element values in closed form. Chebyshev's cutoff is the edge of the ripple band and, at even orders,
+		  its load is not equal to the source
+		- Bessel by Darlington synthesis of the Bessel polynomial, normalised to -3dB at the cutoff
+		then scaled to the source resistance and transformed to highpass (L <-> C) or bandpass (L -> series LC, C -> parallel LC). With a
+		sample rate, the cutoff (or both band edges) is pre-warped for the bilinear transform */
+		struct LadderDesign {
+			enum class Response { butterworth, chebyshev, bessel };
+			enum class Type { lowpass, highpass, bandpass };
+			static constexpr int maxOrder = 10;
+
+			/* fc is the cutoff, or a bandpass's geometric centre, with bandwidth its width between the edges, in Hz; a bandpass needs a
+			bandwidth. Fails, leaving netlist alone, for frequencies or resistances that aren't positive, or band edges that warp together */
+			static juce::Result make(LadderNetlist& netlist, Response response, Type type, int order, double fc, double bandwidth = 0.0,
+				double resistance = 600.0, double rippleDb = 0.5, double sampleRate = 0.0) {
+				jassert(order >= 1 && order <= maxOrder);
+				order = juce::jlimit(1, maxOrder, order);
+
+				jassert(fc > 0.0 && resistance > 0.0);
+				if (!(fc > 0.0))
+					return juce::Result::fail("the cutoff must be above 0 Hz");
+				if (!(resistance > 0.0))
+					return juce::Result::fail("the resistance must be above 0 ohms");
+
+				auto warp = [sampleRate](double f) {
+					return sampleRate > 0.0 ? sampleRate / juce::MathConstants<double>::pi * std::tan(juce::MathConstants<double>::pi * juce::jmin(f, 0.49 * sampleRate) / sampleRate) : f;
+				};
+
+				auto w0 = juce::MathConstants<double>::twoPi * warp(fc), bandwidthW = 0.0;
+				if (type == Type::bandpass) {
+					jassert(bandwidth > 0.0);
+					if (!(bandwidth > 0.0))
+						return juce::Result::fail("a bandpass needs a bandwidth above 0 Hz");
+
+					auto lower = std::sqrt(0.25 * bandwidth * bandwidth + fc * fc) - 0.5 * bandwidth;
+					auto upper = lower + bandwidth;
+					auto lowerW = juce::MathConstants<double>::twoPi * warp(lower), upperW = juce::MathConstants<double>::twoPi * warp(upper);
+					if (!(lower > 0.0 && upperW > lowerW))
+						return juce::Result::fail("the band edges must be above 0 Hz and below Nyquist");
+					w0 = std::sqrt(lowerW * upperW);
+					bandwidthW = upperW - lowerW;
+				}
+
+				double normalisedLoad = 1.0;
+				auto g = prototype(response, order, rippleDb, normalisedLoad);
+
+				LadderNetlist designed;
+				designed.sourceResistance = resistance;
+				designed.loadResistance = resistance * normalisedLoad;
+
+				for (int k = 0; k < order; ++k) {
+					LadderNetlist::Branch branch;
+					branch.shunt = k % 2 == 1; // odd positions (g2, g4, ...) are shunt capacitors in the prototype
+					auto inductance = g[(size_t)k] * resistance, capacitance = g[(size_t)k] / resistance; // at 1 rad/s
+
+					switch (type) {
+					case Type::lowpass:
+						branch.parts.push_back(branch.shunt ? LadderNetlist::Part{ 'C', capacitance / w0 } : LadderNetlist::Part{ 'L', inductance / w0 });
+						break;
+					case Type::highpass:
+						branch.parts.push_back(branch.shunt ? LadderNetlist::Part{ 'L', 1.0 / (capacitance * w0) } : LadderNetlist::Part{ 'C', 1.0 / (inductance * w0) });
+						break;
+					case Type::bandpass:
+						if (branch.shunt) {
+							branch.parts.push_back({ 'C', capacitance / bandwidthW });
+							branch.parts.push_back({ 'L', bandwidthW / (capacitance * w0 * w0) });
+						}
+						else {
+							branch.parts.push_back({ 'L', inductance / bandwidthW });
+							branch.parts.push_back({ 'C', bandwidthW / (inductance * w0 * w0) });
+						}
+						break;
+					}
+					designed.branches.push_back(std::move(branch));
+				}
+				netlist = std::move(designed);
+				return juce::Result::ok();
+			}
+
+			/* g1..gn of the normalised lowpass, and the load in ohms */
+			static std::vector<double> prototype(Response response, int order, double rippleDb, double& load) {
+				std::vector<double> g((size_t)order);
+				auto pi = juce::MathConstants<double>::pi;
+				load = 1.0;
+
+				if (response == Response::butterworth) {
+					for (int k = 1; k <= order; ++k)
+						g[(size_t)(k - 1)] = 2.0 * std::sin((2 * k - 1) * pi / (2.0 * order));
+				}
+				else if (response == Response::chebyshev) {
+					auto beta = std::log(1.0 / std::tanh(rippleDb / 17.37));
+					auto gamma = std::sinh(beta / (2.0 * order));
+					auto a = [=](int k) { return std::sin((2 * k - 1) * pi / (2.0 * order)); };
+					auto b = [=](int k) { return gamma * gamma + std::pow(std::sin(k * pi / order), 2.0); };
+
+					g[0] = 2.0 * a(1) / gamma;
+					for (int k = 2; k <= order; ++k)
+						g[(size_t)(k - 1)] = 4.0 * a(k - 1) * a(k) / (b(k - 1) * g[(size_t)(k - 2)]);
+
+					// even orders don't reach 0 dB at DC, so the load is mismatched to coth^2(beta/4); the passband is then ripple dB down
+					// at its edge, measured as transducer gain (the load voltage times 2 sqrt(Rs / RL))
+					if (order % 2 == 0)
+						load = std::pow(1.0 / std::tanh(beta / 4.0), 2.0);
+				}
+				else {
+					g = synthesiseBessel(order, load);
+				}
+				return g;
+			}
+
+		private:
+			using Complex = std::complex<long double>;
+			using Polynomial = std::vector<long double>; // coefficient of s^k at k
+
+			/* For H(s) = B(0) / B(s) between equal terminations, |S11|^2 = 1 - |H|^2 gives F(s)F(-s) = B(s)B(-s) - B(0)^2. F takes the left
+			half-plane root of every pair, then Z = (B + F) / (B - F) seen from the source expands as a continued fraction into the ladder */
+			static std::vector<double> synthesiseBessel(int order, double& load) {
+				// reverse Bessel polynomial, then scaled so that |H(j)| = 1/sqrt(2)
+				Polynomial B((size_t)order + 1);
+				for (int k = 0; k <= order; ++k)
+					B[(size_t)k] = factorial(2 * order - k) / (std::pow(2.0L, (long double)(order - k)) * factorial(k) * factorial(order - k));
+
+				auto gainSquared = [&](long double w) {
+					Complex sum = 0, jw(0, w), power = 1;
+					for (auto c : B) {
+						sum += c * power;
+						power *= jw;
+					}
+					return B[0] * B[0] / std::norm(sum);
+				};
+				long double low = 0.01L, high = 100.0L;
+				for (int i = 0; i < 200; ++i) {
+					auto mid = std::sqrt(low * high);
+					(gainSquared(mid) > 0.5L ? low : high) = mid;
+				}
+				for (int k = 0; k <= order; ++k)
+					B[(size_t)k] *= std::pow(low, (long double)k);
+
+				// B(s)B(-s) - B(0)^2 is even in s; as a polynomial in u = s^2 its constant term is zero, so u = 0 is a root
+				Polynomial E((size_t)(2 * order + 1), 0.0L);
+				for (int i = 0; i <= order; ++i)
+					for (int k = 0; k <= order; ++k)
+						E[(size_t)(i + k)] += B[(size_t)i] * B[(size_t)k] * ((k % 2) ? -1.0L : 1.0L);
+				Polynomial Q((size_t)order); // E / u
+				for (int m = 1; m <= order; ++m)
+					Q[(size_t)(m - 1)] = E[(size_t)(2 * m)];
+
+				Polynomial F{ 0.0L, B.back() }; // B's leading coefficient times s, for the root at u = 0
+				for (auto u : roots(Q)) {
+					auto s = -std::sqrt(u);
+					if (s.real() > 0)
+						s = -s;
+					F = multiply(F, s);
+				}
+
+				Polynomial numerator((size_t)order + 1), denominator((size_t)order + 1);
+				for (int k = 0; k <= order; ++k) {
+					numerator[(size_t)k] = B[(size_t)k] + F[(size_t)k];
+					denominator[(size_t)k] = B[(size_t)k] - F[(size_t)k];
+				}
+				denominator.pop_back(); // the leading terms cancel
+
+				// each step takes the pole at infinity, s * lead(numerator) / lead(denominator), out of Z (g1, g3, ...) or Y (g2, g4, ...)
+				std::vector<double> g;
+				for (int element = 0; element < order; ++element) {
+					auto value = numerator.back() / denominator.back();
+					g.push_back((double)value);
+					for (size_t k = 0; k < denominator.size(); ++k)
+						numerator[k + 1] -= value * denominator[k];
+					numerator.pop_back();
+
+					if (element + 1 < order) {
+						numerator.pop_back(); // while elements remain the remainder vanishes at infinity, so its top term cancels too
+						std::swap(numerator, denominator);
+					}
+				}
+
+				// what is left is the load, as an impedance after a series L (odd orders) and as a conductance after a shunt C (even orders)
+				auto remainder = (double)(numerator[0] / denominator[0]);
+				load = order % 2 == 1 ? remainder : 1.0 / remainder;
+				return g;
+			}
+
+			static long double factorial(int n) {
+				long double result = 1.0L;
+				for (int i = 2; i <= n; ++i)
+					result *= (long double)i;
+				return result;
+			}
+
+			/* multiplies by (s - root), keeping the real part: roots come in conjugate pairs, so the imaginary parts cancel */
+			static Polynomial multiply(const Polynomial& p, Complex root) {
+				if (std::abs(root.imag()) < 1.0e-12L) {
+					Polynomial result(p.size() + 1, 0.0L);
+					for (size_t k = 0; k < p.size(); ++k) {
+						result[k + 1] += p[k];
+						result[k] -= p[k] * root.real();
+					}
+					return result;
+				}
+				if (root.imag() < 0)
+					return p; // its conjugate does the work: (s - r)(s - r*) = s^2 - 2Re(r)s + |r|^2
+				Polynomial result(p.size() + 2, 0.0L);
+				for (size_t k = 0; k < p.size(); ++k) {
+					result[k + 2] += p[k];
+					result[k + 1] -= 2.0L * root.real() * p[k];
+					result[k] += std::norm(root) * p[k];
+				}
+				return result;
+			}
+
+			/* Durand-Kerner */
+			static std::vector<Complex> roots(const Polynomial& p) {
+				auto degree = (int)p.size() - 1;
+				std::vector<Complex> z((size_t)degree);
+				for (int i = 0; i < degree; ++i)
+					z[(size_t)i] = std::pow(Complex(0.4L, 0.9L), (long double)i);
+
+				auto evaluate = [&](Complex x) {
+					Complex sum = 0;
+					for (int k = degree; k >= 0; --k)
+						sum = sum * x + p[(size_t)k] / p.back();
+					return sum;
+				};
+
+				for (int iteration = 0; iteration < 500; ++iteration) {
+					long double change = 0.0L;
+					for (int i = 0; i < degree; ++i) {
+						Complex denominator = 1;
+						for (int j = 0; j < degree; ++j)
+							if (j != i)
+								denominator *= z[(size_t)i] - z[(size_t)j];
+						auto step = evaluate(z[(size_t)i]) / denominator;
+						z[(size_t)i] -= step;
+						change = juce::jmax(change, std::abs(step));
+					}
+					if (change < 1.0e-18L)
+						break;
+				}
+				return z;
+			}
+		};
+
+	}
+
+}
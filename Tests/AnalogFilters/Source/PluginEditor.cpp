@@ -10,16 +10,24 @@
 #include "PluginEditor.h"
 
 //==============================================================================
-AnalogFiltersAudioProcessorEditor::AnalogFiltersAudioProcessorEditor (AnalogFiltersAudioProcessor& p, juce::AudioParameterFloat * cutoffFrequencyParameter)
-    : AudioProcessorEditor (&p), audioProcessor (p), cutoffFreqSliderAttachment(*cutoffFrequencyParameter, cutoffFreqSlider)
+AnalogFiltersAudioProcessorEditor::AnalogFiltersAudioProcessorEditor (AnalogFiltersAudioProcessor& p, juce::AudioParameterFloat * cutoffFrequencyParameter,
+                                                                      juce::AudioParameterBool * saturateParameter, juce::AudioParameterFloat * driveParameter)
+    : AudioProcessorEditor (&p), audioProcessor (p), cutoffFreqSliderAttachment(*cutoffFrequencyParameter, cutoffFreqSlider),
+    driveSliderAttachment(*driveParameter, driveSlider), saturateButtonAttachment(*saturateParameter, saturateButton, nullptr)
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (400, 300);
+    setSize (600, 300);
 
     cutoffFreqSlider.setRange(20.0, 20000.0, 1);
     cutoffFreqSlider.setTextValueSuffix("Hz");
     addAndMakeVisible(cutoffFreqSlider);
+
+    driveSlider.setRange(0.0, 24.0, 0.1);
+    driveSlider.setTextValueSuffix("dB");
+    addAndMakeVisible(driveSlider);
+
+    addAndMakeVisible(saturateButton);
 }
 
 AnalogFiltersAudioProcessorEditor::~AnalogFiltersAudioProcessorEditor()
@@ -32,20 +40,24 @@ void AnalogFiltersAudioProcessorEditor::paint (juce::Graphics& g)
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
 
-    auto area = getBounds();
+    auto labelArea = getLocalBounds().removeFromTop(sliderLabelHeight);
+    auto cutoffLabelArea = labelArea.removeFromLeft(labelArea.getWidth() / 2);
 
     g.setColour(juce::Colours::white);
-    g.drawFittedText(juce::String("Cutoff Frequency"), area.removeFromTop(sliderLabelHeight), juce::Justification::centred, 2);
+    g.drawFittedText(juce::String("Cutoff Frequency"), cutoffLabelArea, juce::Justification::centred, 2);
+    g.drawFittedText(juce::String("Drive"), labelArea, juce::Justification::centred, 2);
 }
 
 void AnalogFiltersAudioProcessorEditor::resized()
 {
     int sliderTextBoxHeight = 20;
 
-    auto area = getBounds();
+    auto area = getLocalBounds();
     
+    saturateButton.setBounds(area.removeFromBottom(buttonHeight).withSizeKeepingCentre(150, buttonHeight));
     area.removeFromTop(sliderLabelHeight);
     area.removeFromBottom(sliderTextBoxHeight);
 
-    cutoffFreqSlider.setBounds(area.getX(), area.getY(), area.getWidth(), area.getHeight());
+    cutoffFreqSlider.setBounds(area.removeFromLeft(area.getWidth() / 2));
+    driveSlider.setBounds(area);
 }
@@ -20,7 +20,8 @@
 class AnalogFiltersAudioProcessorEditor  : public juce::AudioProcessorEditor
 {
 public:
-    AnalogFiltersAudioProcessorEditor (AnalogFiltersAudioProcessor&, juce::AudioParameterFloat * cutoffFreq);
+    AnalogFiltersAudioProcessorEditor (AnalogFiltersAudioProcessor&, juce::AudioParameterFloat * cutoffFreq, juce::AudioParameterBool * saturate,
+                                       juce::AudioParameterFloat * drive);
     ~AnalogFiltersAudioProcessorEditor() override;
 
     //==============================================================================
@@ -33,9 +34,17 @@ private:
     AnalogFiltersAudioProcessor& audioProcessor;
 
     int sliderLabelHeight = 50;
+    int buttonHeight = 30;
 
     magna::RotarySlider cutoffFreqSlider;
     magna::RotarySliderParameterAttachment cutoffFreqSliderAttachment;
 
+    // drive only acts on the saturating model
+    magna::RotarySlider driveSlider;
+    magna::RotarySliderParameterAttachment driveSliderAttachment;
+
+    juce::ToggleButton saturateButton { "Diode Saturation" };
+    juce::ButtonParameterAttachment saturateButtonAttachment;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalogFiltersAudioProcessorEditor)
 };
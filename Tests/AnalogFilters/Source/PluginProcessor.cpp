@@ -23,6 +23,8 @@ AnalogFiltersAudioProcessor::AnalogFiltersAudioProcessor()
 #endif
 {
     addParameter(cutoffFreqParameter = new juce::AudioParameterFloat("fc", "Cutoff Frequency", 20.0f, 20000.0f, 20000.0f));
+    addParameter(saturateParameter = new juce::AudioParameterBool("saturate", "Diode Saturation", false));
+    addParameter(driveParameter = new juce::AudioParameterFloat("drive", "Drive", 0.0f, 24.0f, 0.0f)); // dB, saturation only
 }
 
 AnalogFiltersAudioProcessor::~AnalogFiltersAudioProcessor()
@@ -94,8 +96,31 @@ void AnalogFiltersAudioProcessor::changeProgramName (int index, const juce::Stri
 //==============================================================================
 void AnalogFiltersAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
-    lpf.reset(sampleRate);
-    lpf.setUsePostWarping(true);
+    auto numChannels = juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels());
+
+    lpf.setUsePostWarping(true); // before prepare(), so the cutoff table is only built once
+    lpf.prepare(sampleRate, numChannels, samplesPerBlock);
+    lpf.setFilterFc(cutoffFreqParameter->get());
+    lpf.reset(); // starts at the current cutoff instead of gliding to it
+
+    saturatingLpf.getFilter().setUsePostWarping(true);
+    saturatingLpf.prepare(sampleRate, numChannels, samplesPerBlock, saturatingOversamplingLog2);
+    saturatingLpf.getFilter().setFilterFc(cutoffFreqParameter->get());
+    saturatingLpf.setDrive(juce::Decibels::decibelsToGain(driveParameter->get()));
+    saturatingLpf.reset();
+
+    // the latency is always the oversampler's: the linear model is delayed to match, so switching models never changes it
+    auto latency = saturatingLpf.getLatencyInSamples();
+    linearDelay.setMaximumDelayInSamples(latency);
+    linearDelay.prepare({ sampleRate, (juce::uint32)samplesPerBlock, (juce::uint32)numChannels });
+    linearDelay.setDelay((float)latency);
+    linearBuffer.setSize(numChannels, samplesPerBlock);
+    setLatencySamples(latency);
+
+    saturating = saturateParameter->get();
+    crossfadeSamples = juce::jmax(1, juce::roundToInt(sampleRate * crossfadeSeconds));
+    warmUpSamples = juce::roundToInt(sampleRate * warmUpSeconds);
+    mixPosition = saturating ? crossfadeSamples : -warmUpSamples;
 }
 
 void AnalogFiltersAudioProcessor::releaseResources()
@@ -143,21 +168,65 @@ void AnalogFiltersAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
     
+    // only sets the target; the filter glides to it
     lpf.setFilterFc(cutoffFreqParameter->get());
+    saturatingLpf.getFilter().setFilterFc(cutoffFreqParameter->get());
+    // drive pushes the signal harder into the diodes; the filter takes it off again afterwards, so only the distortion changes
+    saturatingLpf.setDrive(juce::Decibels::decibelsToGain(driveParameter->get()));
+
+    // the mix heads towards whichever model is selected; see processModels()
+    saturating = saturateParameter->get();
+
+    // in pieces no longer than the scratch buffer prepareToPlay() sized
+    auto block = juce::dsp::AudioBlock<float>(buffer).getSubsetChannelBlock(0, (size_t)juce::jmin(totalNumInputChannels, linearBuffer.getNumChannels()));
+    auto maxBlockSize = (size_t)linearBuffer.getNumSamples();
+    for (size_t start = 0; start < block.getNumSamples(); start += maxBlockSize)
+        processModels(block.getSubBlock(start, juce::jmin(maxBlockSize, block.getNumSamples() - start)));
+}
+
+void AnalogFiltersAudioProcessor::processModels(juce::dsp::AudioBlock<float> block)
+{
+    auto numChannels = (int)block.getNumChannels();
+    auto numSamples = (int)block.getNumSamples();
+
+    // mixPosition moves a sample at a time towards the selected model: from -warmUpSamples to 0 the saturating model runs, unheard, until
+    // its state has caught up with the signal, then from 0 to crossfadeSamples it fades in; going back it fades out at once, since the
+    // linear model never stops
+    auto direction = saturating ? 1 : -1;
+    auto start = mixPosition;
+    mixPosition = juce::jlimit(-warmUpSamples, crossfadeSamples, start + direction * numSamples);
+
+    // the delay line lines the linear model up with the oversampled one
+    for (int channel = 0; channel < numChannels; ++channel) {
+        auto* input = block.getChannelPointer((size_t)channel);
+        auto* delayed = linearBuffer.getWritePointer(channel);
+        for (int i = 0; i < numSamples; ++i) {
+            linearDelay.pushSample(channel, input[i]);
+            delayed[i] = linearDelay.popSample(channel);
+        }
+    }
+
+    // every channel keeps its own filter state; the filter runs them side by side in SIMD lanes. It is cheap, so it always runs and is
+    // warm whenever it has to take over
+    lpf.process(linearBuffer.getArrayOfWritePointers(), numChannels, numSamples);
+    if (juce::jmax(start, mixPosition) > -warmUpSamples)
+        saturatingLpf.process(block);
+
+    if (juce::jmin(start, mixPosition) >= crossfadeSamples)
+        return;
+    if (juce::jmax(start, mixPosition) <= 0) {
+        block.copyFrom(linearBuffer, 0, 0, (size_t)numSamples);
+        return;
+    }
 
-    // This is the place where you'd normally do the guts of your plugin's
-    // audio processing...
-    // Make sure to reset the state if your inner loop is processing
-    // the samples and the outer loop is handling the channels.
-    // Alternatively, you can process the samples with the channels
-    // interleaved by keeping the same state.
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
-    {
-        auto* channelData = buffer.getWritePointer (channel);
-        for (int sample = 0; sample < buffer.getNumSamples(); sample++) {
-            double xn = channelData[sample];
-            double yn = lpf.processAudioSample(xn);
-            channelData[sample] = yn;
+    // the two paths line up, so crossfading between them doesn't comb-filter
+    for (int channel = 0; channel < numChannels; ++channel) {
+        auto* output = block.getChannelPointer((size_t)channel);
+        auto* linear = linearBuffer.getReadPointer(channel);
+        for (int i = 0; i < numSamples; ++i) {
+            auto position = juce::jlimit(-warmUpSamples, crossfadeSamples, start + direction * (i + 1));
+            auto saturatedGain = (float)juce::jmax(0, position) / (float)crossfadeSamples;
+            output[i] = linear[i] + saturatedGain * (output[i] - linear[i]);
         }
     }
 }
@@ -170,7 +239,7 @@ bool AnalogFiltersAudioProcessor::hasEditor() const
 
 juce::AudioProcessorEditor* AnalogFiltersAudioProcessor::createEditor()
 {
-    return new AnalogFiltersAudioProcessorEditor (*this, cutoffFreqParameter);
+    return new AnalogFiltersAudioProcessorEditor (*this, cutoffFreqParameter, saturateParameter, driveParameter);
 }
 
 //==============================================================================
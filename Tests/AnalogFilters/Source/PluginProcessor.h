@@ -57,7 +57,24 @@ public:
 private:
     //==============================================================================
     juce::AudioParameterFloat * cutoffFreqParameter;
-    WDFTunableButterLPF3 lpf;
+    juce::AudioParameterBool * saturateParameter;
+    juce::AudioParameterFloat * driveParameter;
+
+    magna::TunableButterLPF3<> lpf; // one state per channel in SIMD lanes; double, as float is no faster for 2 channels (Tests/WDFPrecision)
+
+    // the same filter with diodes across C1, run at 4x so the clipping doesn't alias
+    static constexpr int saturatingOversamplingLog2 = 2;
+    magna::OversampledFilter<magna::TunableSaturatingLPF3<>> saturatingLpf;
+    bool saturating = false;
+
+    // the linear model runs behind a delay matching the oversampler's latency, and the two crossfade when the model changes. The
+    // saturating model runs for warmUpSeconds before it is heard, long enough for the LPF3 to settle at its lowest cutoff
+    static constexpr double crossfadeSeconds = 0.01, warmUpSeconds = 0.1;
+    juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None> linearDelay;
+    juce::AudioBuffer<float> linearBuffer;
+    int crossfadeSamples = 1, warmUpSamples = 0, mixPosition = 0;
+
+    void processModels(juce::dsp::AudioBlock<float> block);
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalogFiltersAudioProcessor)
 };
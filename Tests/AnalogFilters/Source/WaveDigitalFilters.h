@@ -1,39 +1,93 @@
 #include "../../../../fxobjects/fxobjects.h"
+#include "../../../MyJUCEFiles/AnalogCircuits.h"
+#include "../../../MyJUCEFiles/WDFLadders.h"
 
+/* Rs - series L1 - shunt C1 - series L2 - RL, Butterworth at 1kHz. The adaptor chain (seriesAdaptor_L1 -> parallelAdaptor_C1 ->
+seriesTerminatedAdaptor_L2) is a magna::ButterLPF3Circuit, whose wdf:: templates inline into one kernel with the component values
+set in reset(), so neither path walks pointer-linked adaptors. processAudioBlock() runs that kernel over a whole buffer without a
+virtual call per sample; processAudioSample() shares the same state. Precision is one of magna::wdf's: with SinglePrecision a float
+buffer runs through without a conversion per sample */
+template <typename Precision = magna::wdf::DoublePrecision>
 class WDFButterLPF3 : public IAudioSignalProcessor {
 public:
 	WDFButterLPF3() { createWDF(); }
 	~WDFButterLPF3() {}
+
+	virtual bool reset(double sampleRate) {
+		circuit.setComponents(L1, C1, L2, sampleRate);
+		circuit.reset();
+		return true;
+	}
+
+	virtual double processAudioSample(double xn) {
+		return (double)circuit.process((Element)xn);
+	}
+
+	void processAudioBlock(double* data, int numSamples) noexcept {
+		auto c = circuit; // a local copy lets the compiler keep the state in registers
+		for (int i = 0; i < numSamples; ++i)
+			data[i] = (double)c.process((Element)data[i]);
+		circuit = c;
+	}
+
+	void processAudioBlock(float* data, int numSamples) noexcept {
+		auto c = circuit;
+		for (int i = 0; i < numSamples; ++i)
+			data[i] = (float)c.process((Element)data[i]);
+		circuit = c;
+	}
+
 protected:
-	WdfSeriesAdaptor seriesAdaptor_L1;
-	WdfParallelAdaptor parallelAdaptor_C1;
-	WdfSeriesTerminatedAdaptor seriesTerminatedAdaptor_L2;
+	using Element = typename Precision::Element;
+
+	double L1 = 0.0, C1 = 0.0, L2 = 0.0; // henries, farads
+	magna::ButterLPF3Circuit<Element, Precision::template State> circuit;
 
 	void createWDF() {
-		seriesAdaptor_L1.setComponent(wdfComponent::L, 95.49e-3);
-		parallelAdaptor_C1.setComponent(wdfComponent::C, 0.5305e-6);
-		seriesTerminatedAdaptor_L2.setComponent(wdfComponent::L, 95.49e-3);
-		
-		/*connections*/
-		WdfAdaptorBase::connectAdaptors(&seriesAdaptor_L1, &parallelAdaptor_C1);
-		WdfAdaptorBase::connectAdaptors(&parallelAdaptor_C1, &seriesTerminatedAdaptor_L2);
+		L1 = 95.49e-3;
+		C1 = 0.5305e-6;
+		L2 = 95.49e-3;
+		// source and terminal resistances are 600 ohms, see magna::ButterLPF3Circuit
+	}
+};
+
+/* Any doubly terminated RLC ladder, from a netlist (see magna::wdf::LadderNetlist) or a magna::wdf::LadderDesign; the same filter as
+WDFButterLPF3 is
+	source 600 / series L 95.49m / shunt C 530.5n / series L 95.49m / load 600
+(one per line). setNetlist() allocates and is not for the audio thread; reset() only recomputes the adaptors for the new sample rate */
+class WDFLadder : public IAudioSignalProcessor {
+public:
+	WDFLadder() {}
+	~WDFLadder() {}
 
-		/*set resistances*/
-		seriesAdaptor_L1.setSourceResistance(600.0);
-		seriesTerminatedAdaptor_L2.setTerminalResistance(600.0);
+	juce::Result setNetlist(const juce::String& text) {
+		magna::wdf::LadderNetlist parsed;
+		auto result = parsed.parse(text);
+		if (result.wasOk())
+			setNetlist(parsed);
+		return result;
 	}
 
-	virtual bool reset(double sampleRate) {
-		seriesAdaptor_L1.reset(sampleRate);
-		parallelAdaptor_C1.reset(sampleRate);
-		seriesTerminatedAdaptor_L2.reset(sampleRate);
+	void setNetlist(const magna::wdf::LadderNetlist& newNetlist) {
+		netlist = newNetlist;
+		circuit.prepare(netlist, sampleRate);
+	}
 
-		seriesAdaptor_L1.initializeAdaptorChain();
+	virtual bool reset(double newSampleRate) {
+		sampleRate = newSampleRate;
+		if (!circuit.isPrepared())
+			return false;
+		circuit.update(sampleRate);
+		circuit.reset();
 		return true;
 	}
 
 	virtual double processAudioSample(double xn) {
-		seriesAdaptor_L1.setInput1(xn);
-		return seriesTerminatedAdaptor_L2.getOutput2();
+		return circuit.isPrepared() ? circuit.process(xn) : xn;
 	}
-};
\ No newline at end of file
+
+protected:
+	double sampleRate = 44100.0;
+	magna::wdf::LadderNetlist netlist;
+	magna::wdf::LadderCircuit<double> circuit;
+};
@@ -11,26 +11,51 @@
 
 //==============================================================================
 AudioVisualisersAudioProcessorEditor::AudioVisualisersAudioProcessorEditor (AudioVisualisersAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p), visualiser(2, 2, NO_OVERLAY)
+    : AudioProcessorEditor (&p), audioProcessor (p), visualiser(2, 2, AudioVisualiser::Overlay::none)
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (800, 300);
+    setSize (800, 600);
 
     addAndMakeVisible(visualiser);
 
     // clear buffer here instead of in prepareToPlay() as editor could be opened/closed at any time
     visualiser.clear();
-    visualiser.setSamplesPerBlock(64);
-    visualiser.setRepaintRate(20);
+    visualiser.setSamplesPerColumn(64);
+    visualiser.setFrameRateRange(10, 60); // adapts to how long the visualiser takes to draw and how busy the GUI is
 
-    // share visualizer component with processor
-    audioProcessor.setVisualiserPointer(&visualiser);
+    // the analysis views run at the processor's rate, or 44.1kHz if the editor opens before prepareToPlay()
+    auto sampleRate = audioProcessor.getSampleRate() > 0.0 ? audioProcessor.getSampleRate() : 44100.0;
+    auto numChannels = audioProcessor.getTotalNumInputChannels() + audioProcessor.getTotalNumOutputChannels();
+    spectrum.prepare(sampleRate, numChannels);
+    spectrogram.prepare(sampleRate, numChannels);
+    goniometer.prepare(sampleRate);
+
+    // the goniometer and the loudness meter measure the outputs, which come after the inputs in the feed
+    auto numInputs = audioProcessor.getTotalNumInputChannels(), numOutputs = audioProcessor.getTotalNumOutputChannels();
+    if (numOutputs >= 2)
+        goniometer.setStereoPair(numInputs, numInputs + 1);
+    loudness.prepare(sampleRate, std::vector<float>((size_t)juce::jmax(1, numOutputs), 1.0f)); // mono or stereo, so every channel weighs 1.0
+    loudness.setFirstChannel(numInputs);
+
+    for (auto* view : getAnalysisViews())
+        addAndMakeVisible(view);
+
+    // every visualiser pulls the processor's samples from its own feed, on its own timer
+    visualiser.setSource(&audioProcessor.getVisualiserFifo(AudioVisualisersAudioProcessor::waveformFeed));
+    spectrum.setSource(&audioProcessor.getVisualiserFifo(AudioVisualisersAudioProcessor::spectrumFeed));
+    spectrogram.setSource(&audioProcessor.getVisualiserFifo(AudioVisualisersAudioProcessor::spectrogramFeed));
+    goniometer.setSource(&audioProcessor.getVisualiserFifo(AudioVisualisersAudioProcessor::goniometerFeed));
+    loudness.setSource(&audioProcessor.getVisualiserFifo(AudioVisualisersAudioProcessor::loudnessFeed));
+
+    startTimerHz(2);
 }
 
 AudioVisualisersAudioProcessorEditor::~AudioVisualisersAudioProcessorEditor()
 {
-    audioProcessor.setVisualiserPointer(nullptr);
+    visualiser.setSource(nullptr);
+    for (auto* view : getAnalysisViews())
+        view->setSource(nullptr);
 }
 
 //==============================================================================
@@ -42,7 +67,22 @@ void AudioVisualisersAudioProcessorEditor::paint (juce::Graphics& g)
     g.setColour (juce::Colours::white);
     g.setFont (15.0f);
 
-    visualiser.paint(g);
+    // one column per view: the frame rate its governor settled on and its average paint time
+    std::vector<std::pair<juce::String, AudioFeedVisualiser*>> views{ { "waveform", &visualiser }, { "spectrum", &spectrum },
+        { "spectrogram", &spectrogram }, { "goniometer", &goniometer }, { "loudness", &loudness } };
+    auto area = statisticsArea;
+    auto width = area.getWidth() / (int)views.size();
+    g.setFont (12.0f);
+    for (auto& view : views) {
+        auto& statistics = view.second->getRenderStatistics();
+        g.drawText (view.first + " " + juce::String (statistics.frameRateHz) + " Hz " + juce::String (statistics.averagePaintMs, 2) + " ms",
+                    area.removeFromLeft (width), juce::Justification::centredLeft, true);
+    }
+}
+
+void AudioVisualisersAudioProcessorEditor::timerCallback()
+{
+    repaint (statisticsArea);
 }
 
 void AudioVisualisersAudioProcessorEditor::resized()
@@ -50,5 +90,14 @@ void AudioVisualisersAudioProcessorEditor::resized()
     // This is generally where you'll want to lay out the positions of any
     // subcomponents in your editor..
     int offset = 10;
-    visualiser.setBounds(offset, offset, getWidth() - (offset<<1), getHeight() - (offset<<1));
+    auto bounds = getLocalBounds().reduced(offset);
+    statisticsArea = bounds.removeFromBottom(16);
+    bounds.removeFromBottom(offset);
+    visualiser.setBounds(bounds.removeFromTop((bounds.getHeight() - offset) / 2));
+    bounds.removeFromTop(offset);
+
+    auto views = getAnalysisViews();
+    auto width = (bounds.getWidth() + offset) / (int)views.size();
+    for (auto* view : views)
+        view->setBounds(bounds.removeFromLeft(width).withTrimmedRight(offset));
 }
@@ -14,7 +14,7 @@
 //==============================================================================
 /**
 */
-class AudioVisualisersAudioProcessorEditor  : public juce::AudioProcessorEditor
+class AudioVisualisersAudioProcessorEditor  : public juce::AudioProcessorEditor, private juce::Timer
 {
 public:
     AudioVisualisersAudioProcessorEditor (AudioVisualisersAudioProcessor&);
@@ -29,6 +29,17 @@ private:
     // access the processor object that created it.
     AudioVisualisersAudioProcessor& audioProcessor;
     AudioVisualiser visualiser;
+    FrequencyVisualiser spectrum;
+    SpectrogramVisualiser spectrogram;
+    GoniometerVisualiser goniometer;
+    LoudnessVisualiser loudness;
+
+    /* the views laid out side by side under the waveform */
+    std::vector<AudioFeedVisualiser*> getAnalysisViews() { return { &spectrum, &spectrogram, &goniometer, &loudness }; }
+
+    /* every view's governed frame rate and paint time, along the bottom edge, refreshed twice a second */
+    juce::Rectangle<int> statisticsArea;
+    void timerCallback() override;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioVisualisersAudioProcessorEditor)
 };
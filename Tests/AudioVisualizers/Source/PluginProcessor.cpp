@@ -9,6 +9,10 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+#if AUDIO_VISUALISERS_COUNT_ALLOCATIONS
+MAGNA_DEFINE_COUNTING_OPERATOR_NEW
+#endif
+
 //==============================================================================
 AudioVisualisersAudioProcessor::AudioVisualisersAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -22,7 +26,8 @@ AudioVisualisersAudioProcessor::AudioVisualisersAudioProcessor()
                        )
 #endif
 {
-
+    for (int feed = 0; feed < numVisualiserFeeds; ++feed)
+        visualiserFifos.add(new magna::AudioSampleFifo(16, 1 << 15));
 }
 
 AudioVisualisersAudioProcessor::~AudioVisualisersAudioProcessor()
@@ -96,12 +101,22 @@ void AudioVisualisersAudioProcessor::prepareToPlay (double sampleRate, int sampl
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
+    maxSamplesPerBlock = juce::jmax(1, samplesPerBlock);
+    inputCopy.setSize(getTotalNumInputChannels(), maxSamplesPerBlock);
+    bufferInOutSplit.assign((size_t)(getTotalNumInputChannels() + getTotalNumOutputChannels()), nullptr);
+
+   #if AUDIO_VISUALISERS_COUNT_ALLOCATIONS
+    magna::AllocationCounter::reset();
+   #endif
 }
 
 void AudioVisualisersAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+   #if AUDIO_VISUALISERS_COUNT_ALLOCATIONS
+    DBG("AudioVisualisers: " << magna::AllocationCounter::getCount() << " heap allocations in processBlock() since prepareToPlay()");
+   #endif
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -130,15 +145,20 @@ bool AudioVisualisersAudioProcessor::isBusesLayoutSupported (const BusesLayout&
 
 void AudioVisualisersAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+   #if AUDIO_VISUALISERS_COUNT_ALLOCATIONS
+    magna::AllocationCounter::Scope countAllocations;
+   #endif
+
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
     auto numSamples = buffer.getNumSamples();
     int newTotalChannels = totalNumInputChannels + totalNumOutputChannels;
 
-    /* using this buffer to write to output w/o writing over input yet */
-    juce::AudioBuffer<float> bufferInOutSplit(newTotalChannels, numSamples);
-    bufferInOutSplit.clear();
+    // the split buffers are sized in prepareToPlay(); a layout change without one isn't expected
+    jassert(inputCopy.getNumChannels() == totalNumInputChannels && (int)bufferInOutSplit.size() == newTotalChannels);
+    if (inputCopy.getNumChannels() != totalNumInputChannels || (int)bufferInOutSplit.size() != newTotalChannels)
+        return;
 
     // In case we have more outputs than inputs, this code clears any output
     // channels that didn't contain input data, (because these aren't
@@ -150,33 +170,29 @@ void AudioVisualisersAudioProcessor::processBlock(juce::AudioBuffer<float>& buff
         buffer.clear(i, 0, numSamples);
     }
 
-    // This is the place where you'd normally do the guts of your plugin's
-    // audio processing...
-    // Make sure to reset the state if your inner loop is processing
-    // the samples and the outer loop is handling the channels.
-    // Alternatively, you can process the samples with the channels
-    // interleaved by keeping the same state.
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
-    {
-        auto* channelData = buffer.getWritePointer (channel);
-        bufferInOutSplit.copyFrom(channel, 0, buffer.getReadPointer(channel), numSamples);
-        // do things to output...
-        if (channel + totalNumInputChannels < totalChannels) { // if corresponding output channel exists...
-            bufferInOutSplit.copyFrom(channel + totalNumInputChannels, 0, channelData, numSamples); // copy to bufferInOutSplit
+    // hosts may send more samples than promised in prepareToPlay(), so the input copy is filled (and pushed) in chunks it can hold
+    for (int start = 0; start < numSamples; start += maxSamplesPerBlock) {
+        auto chunkSize = juce::jmin(maxSamplesPerBlock, numSamples - start);
+
+        /* the inputs are copied before the output is written over them; the outputs are pushed straight from the host buffer */
+        for (int channel = 0; channel < totalNumInputChannels; ++channel) {
+            inputCopy.copyFrom(channel, 0, buffer, channel, start, chunkSize);
+            bufferInOutSplit[(size_t)channel] = inputCopy.getReadPointer(channel);
         }
-    }
 
-    // only do anything with visualizer if it's safe (not actively being re-assigned)
-    std::unique_lock<spin_lock> tryLock(mutex, std::try_to_lock);
-    if (tryLock.owns_lock()) {
-        if (visualiserPtr.get() != nullptr) {
-            if (newTotalChannels != totalChannels) // buffer (itself) is only 2-channels
-                (*visualiserPtr)->setNumChannels(newTotalChannels);// + totalNumOutputChannels);
-            (*visualiserPtr)->pushBuffer(bufferInOutSplit);
+        // This is the place where you'd normally do the guts of your plugin's
+        // audio processing...
+        for (int channel = 0; channel < totalNumOutputChannels; ++channel) {
+            auto* channelData = buffer.getWritePointer(channel, start);
+            // do things to output...
+            bufferInOutSplit[(size_t)(totalNumInputChannels + channel)] = channelData;
         }
-    }
 
-    totalChannels = newTotalChannels;
+        // never touches the visualisers themselves: if one has fallen behind, this chunk is dropped from its feed rather than waited on
+        for (auto* fifo : visualiserFifos)
+            if (fifo->isConsumerActive())
+                fifo->push(bufferInOutSplit.data(), newTotalChannels, chunkSize);
+    }
 }
 
 //==============================================================================
@@ -210,8 +226,3 @@ juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 {
     return new AudioVisualisersAudioProcessor();
 }
-
-void AudioVisualisersAudioProcessor::setVisualiserPointer(AudioVisualiser * visualiserPtr) {
-    std::lock_guard<spin_lock> lock(mutex); // un-locks mutex once out of scope
-    this->visualiserPtr = std::make_unique<AudioVisualiser*>(visualiserPtr);
-}
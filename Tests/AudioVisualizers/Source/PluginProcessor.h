@@ -10,7 +10,13 @@
 
 #include <JuceHeader.h>
 #include "AudioVisualizers.h"
-#include "ThreadFunctions.h"//spin_lock
+#include "ThreadFunctions.h"//AudioSampleFifo, AllocationCounter
+
+/* count heap allocations made inside processBlock() (reported in releaseResources()). Off unless defined to 1 in the project: it replaces the
+process-wide operator new, which is the host's too */
+#ifndef AUDIO_VISUALISERS_COUNT_ALLOCATIONS
+#define AUDIO_VISUALISERS_COUNT_ALLOCATIONS 0
+#endif
 
 //==============================================================================
 /**
@@ -55,14 +61,21 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
-    void setVisualiserPointer(AudioVisualiser* visualiserPtr);
+    /* one feed per visualiser in the editor, since each FIFO has a single reader. The visualisers drain them on their timers; the audio
+       thread only ever writes samples into them, and skips the feeds nobody is reading */
+    enum VisualiserFeed { waveformFeed, spectrumFeed, spectrogramFeed, goniometerFeed, loudnessFeed, numVisualiserFeeds };
+    magna::AudioSampleFifo& getVisualiserFifo(VisualiserFeed feed) { return *visualiserFifos[feed]; }
 
 private:
     //==============================================================================
     std::vector<juce::Colour> audioVisualizerColors{juce::Colours::black, juce::Colours::green, juce::Colours::cyan, juce::Colours::orange, juce::Colours::purple};
-    std::unique_ptr<AudioVisualiser*> visualiserPtr;
-    spin_lock mutex;
-    int totalChannels = 2;
+    juce::OwnedArray<magna::AudioSampleFifo> visualiserFifos; // up to 8 inputs + 8 outputs each, ~0.7s at 48kHz
+
+    /* inputs are copied here before the output is written, then pushed to the visualiser alongside the (aliased) output channels.
+       Sized in prepareToPlay(), so processBlock() never allocates */
+    juce::AudioBuffer<float> inputCopy;
+    std::vector<const float*> bufferInOutSplit;
+    int maxSamplesPerBlock = 0;
 
     bool bufferReadyToBePushed = false;
 
@@ -0,0 +1,345 @@
+/*
+  ==============================================================================
+
+	Numerical accuracy report for the WDF filters in single and mixed precision.
+
+	Renders the same noise and step inputs through magna::TunableButterLPF3 in
+	DoublePrecision on double buffers (the reference) and through each precision
+	on float buffers (as a plugin runs it), then reports every output's error
+	against the reference for each sample rate and cutoff, for a swept cutoff,
+	and what each precision costs per sample.
+
+	Then checks the fxobjects-style wrappers in Tests/AnalogFilters at their
+	fixed 1kHz cutoff: WDFButterLPF3's processAudioBlock() against its
+	processAudioSample(), and both, with WDFLadders of the same circuit, against
+	TunableButterLPF3.
+
+	WDFPrecision [--rates 44100,48000,96000,192000] [--cutoffs 20,100,1000,10000,20000]
+	             [--seconds 5] [--block 512] [--repeats 3]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../AnalogFilters/Source/WaveDigitalFilters.h"
+
+namespace {
+	struct Options {
+		juce::Array<double> sampleRates{ 44100.0, 48000.0, 96000.0, 192000.0 };
+		juce::Array<double> cutoffs{ 20.0, 100.0, 1000.0, 10000.0, 20000.0 };
+		double seconds = 5.0;
+		int blockSize = 512;
+		int repeats = 3;
+	};
+
+	constexpr int numChannels = 2;
+	constexpr double sweepCutoff = 0.0; // in Options::cutoffs' place, a 0.5Hz exponential sweep from 20Hz to 20kHz and back
+
+	void printUsage() {
+		std::cout << "usage: WDFPrecision [--rates Hz,Hz,...] [--cutoffs Hz,Hz,...] [--seconds s] [--block n] [--repeats n]" << std::endl;
+	}
+
+	bool parseList(const juce::String& value, juce::Array<double>& list) {
+		list.clearQuick();
+		for (auto& item : juce::StringArray::fromTokens(value, ",", {}))
+			if (item.getDoubleValue() > 0.0)
+				list.add(item.getDoubleValue());
+			else
+				return false;
+		return !list.isEmpty();
+	}
+
+	bool parseOptions(const juce::StringArray& args, Options& options) {
+		if (args.size() % 2 != 0)
+			return false;
+
+		for (int i = 0; i < args.size(); i += 2) {
+			auto& arg = args[i];
+			auto& value = args[i + 1];
+
+			if (arg == "--rates") {
+				if (!parseList(value, options.sampleRates))
+					return false;
+			}
+			else if (arg == "--cutoffs") {
+				if (!parseList(value, options.cutoffs))
+					return false;
+			}
+			else if (arg == "--seconds")				options.seconds = value.getDoubleValue();
+			else if (arg == "--block")					options.blockSize = value.getIntValue();
+			else if (arg == "--repeats")				options.repeats = value.getIntValue();
+			else										return false;
+		}
+		return options.seconds > 0.0 && options.blockSize > 0 && options.repeats > 0;
+	}
+
+	/* decorrelated white noise per channel at -6dBFS peak, or a step to -6dBFS, already rounded to float so every precision gets the
+	same input */
+	juce::AudioBuffer<double> makeInput(bool step, int numSamples) {
+		juce::Random random(0x5eed);
+		juce::AudioBuffer<double> input(numChannels, numSamples);
+		for (int channel = 0; channel < numChannels; ++channel) {
+			auto* data = input.getWritePointer(channel);
+			for (int i = 0; i < numSamples; ++i)
+				data[i] = step ? 0.5 : (double)((random.nextFloat() * 2.0f - 1.0f) * 0.5f);
+		}
+		return input;
+	}
+
+	double cutoffAt(double fc, int64_t position, double sampleRate) {
+		if (fc != sweepCutoff)
+			return fc;
+		auto phase = std::sin(juce::MathConstants<double>::twoPi * 0.5 * (double)position / sampleRate);
+		return 20.0 * std::pow(1000.0, 0.5 + 0.5 * phase);
+	}
+
+	/* the cutoff is set once per block, as a parameter would be */
+	template <typename Precision, typename SampleType>
+	double render(juce::AudioBuffer<SampleType>& buffer, double sampleRate, double fc, int blockSize, bool postWarping = true) {
+		magna::TunableButterLPF3<Precision> filter;
+		filter.setUsePostWarping(postWarping); // before prepare(), so the cutoff table is only built once
+		filter.prepare(sampleRate, buffer.getNumChannels(), blockSize);
+		filter.setFilterFc(cutoffAt(fc, 0, sampleRate));
+		filter.reset();
+
+		std::vector<SampleType*> channels((size_t)buffer.getNumChannels());
+		auto seconds = 0.0;
+		for (int position = 0; position < buffer.getNumSamples(); position += blockSize) {
+			auto numSamples = juce::jmin(blockSize, buffer.getNumSamples() - position);
+			for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+				channels[(size_t)channel] = buffer.getWritePointer(channel) + position;
+
+			juce::ScopedNoDenormals noDenormals;
+			auto startTicks = juce::Time::getHighResolutionTicks();
+			filter.setFilterFc(cutoffAt(fc, position, sampleRate));
+			filter.process(channels.data(), buffer.getNumChannels(), numSamples);
+			seconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+		}
+		return seconds;
+	}
+
+	struct Error {
+		double relativeDb = -300.0;	// RMS error over RMS reference
+		double peakDbfs = -300.0;	// largest single-sample error
+	};
+
+	template <typename SampleType>
+	Error compare(const juce::AudioBuffer<double>& reference, const juce::AudioBuffer<SampleType>& output) {
+		double errorSquares = 0.0, referenceSquares = 0.0, peak = 0.0;
+		for (int channel = 0; channel < numChannels; ++channel) {
+			const auto* expected = reference.getReadPointer(channel);
+			const auto* actual = output.getReadPointer(channel);
+			for (int i = 0; i < reference.getNumSamples(); ++i) {
+				auto error = (double)actual[i] - expected[i];
+				errorSquares += error * error;
+				referenceSquares += expected[i] * expected[i];
+				peak = juce::jmax(peak, std::abs(error));
+			}
+		}
+
+		Error result;
+		if (errorSquares > 0.0 && referenceSquares > 0.0)
+			result.relativeDb = 10.0 * std::log10(errorSquares / referenceSquares);
+		if (peak > 0.0)
+			result.peakDbfs = 20.0 * std::log10(peak);
+		return result;
+	}
+
+	template <typename Precision>
+	Error measure(const juce::AudioBuffer<double>& input, const juce::AudioBuffer<double>& reference, double sampleRate, double fc, int blockSize) {
+		juce::AudioBuffer<float> output(numChannels, input.getNumSamples());
+		for (int channel = 0; channel < numChannels; ++channel)
+			for (int i = 0; i < input.getNumSamples(); ++i)
+				output.setSample(channel, i, (float)input.getSample(channel, i));
+		render<Precision>(output, sampleRate, fc, blockSize);
+		return compare(reference, output);
+	}
+
+	juce::String formatDb(double db) {
+		return db <= -300.0 ? juce::String("exact") : juce::String(db, 1);
+	}
+
+	void printError(double sampleRate, double fc, const char* precision, Error noise, Error step) {
+		std::cout << juce::String((int)sampleRate).paddedLeft(' ', 7)
+			<< (fc == sweepCutoff ? juce::String("sweep") : juce::String((int)fc)).paddedLeft(' ', 8)
+			<< juce::String(precision).paddedLeft(' ', 8)
+			<< formatDb(noise.relativeDb).paddedLeft(' ', 12) << formatDb(noise.peakDbfs).paddedLeft(' ', 12)
+			<< formatDb(step.relativeDb).paddedLeft(' ', 12) << formatDb(step.peakDbfs).paddedLeft(' ', 12) << std::endl;
+	}
+
+	/* each variant against the reference, on noise and on a step (which shows DC gain errors and slow settling) */
+	void reportAccuracy(const Options& options) {
+		std::cout << "error against DoublePrecision on double buffers; the others run on float buffers, so \"double\" is the float I/O floor"
+			<< std::endl << std::endl;
+		std::cout << juce::String("rate").paddedLeft(' ', 7) << juce::String("cutoff").paddedLeft(' ', 8) << juce::String("").paddedLeft(' ', 8)
+			<< juce::String("noise dB").paddedLeft(' ', 12) << juce::String("peak dBFS").paddedLeft(' ', 12)
+			<< juce::String("step dB").paddedLeft(' ', 12) << juce::String("peak dBFS").paddedLeft(' ', 12) << std::endl;
+
+		auto cutoffs = options.cutoffs;
+		cutoffs.add(sweepCutoff);
+
+		for (auto sampleRate : options.sampleRates) {
+			auto numSamples = (int)(options.seconds * sampleRate);
+			auto noise = makeInput(false, numSamples), step = makeInput(true, numSamples);
+
+			for (auto fc : cutoffs) {
+				if (fc >= 0.49 * sampleRate)
+					continue;
+
+				auto noiseReference = noise, stepReference = step;
+				render<magna::wdf::DoublePrecision>(noiseReference, sampleRate, fc, options.blockSize);
+				render<magna::wdf::DoublePrecision>(stepReference, sampleRate, fc, options.blockSize);
+
+				printError(sampleRate, fc, "double",
+					measure<magna::wdf::DoublePrecision>(noise, noiseReference, sampleRate, fc, options.blockSize),
+					measure<magna::wdf::DoublePrecision>(step, stepReference, sampleRate, fc, options.blockSize));
+				printError(sampleRate, fc, "mixed",
+					measure<magna::wdf::MixedPrecision>(noise, noiseReference, sampleRate, fc, options.blockSize),
+					measure<magna::wdf::MixedPrecision>(step, stepReference, sampleRate, fc, options.blockSize));
+				printError(sampleRate, fc, "single",
+					measure<magna::wdf::SinglePrecision>(noise, noiseReference, sampleRate, fc, options.blockSize),
+					measure<magna::wdf::SinglePrecision>(step, stepReference, sampleRate, fc, options.blockSize));
+			}
+		}
+	}
+
+	/* Tests/AnalogFilters' fxobjects-style wrappers are single channel and fixed at 1kHz; these run one per channel */
+	constexpr double wrapperCutoff = 1000.0;
+
+	template <typename Processor, typename Setup>
+	juce::AudioBuffer<double> renderSamples(const juce::AudioBuffer<double>& input, double sampleRate, Setup setup) {
+		auto output = input;
+		for (int channel = 0; channel < numChannels; ++channel) {
+			Processor processor;
+			setup(processor);
+			processor.reset(sampleRate);
+			auto* data = output.getWritePointer(channel);
+			for (int i = 0; i < output.getNumSamples(); ++i)
+				data[i] = processor.processAudioSample(data[i]);
+		}
+		return output;
+	}
+
+	template <typename Precision, typename SampleType>
+	juce::AudioBuffer<SampleType> renderBlocks(const juce::AudioBuffer<double>& input, double sampleRate, int blockSize) {
+		juce::AudioBuffer<SampleType> output(numChannels, input.getNumSamples());
+		for (int channel = 0; channel < numChannels; ++channel) {
+			WDFButterLPF3<Precision> processor;
+			processor.reset(sampleRate);
+			auto* data = output.getWritePointer(channel);
+			for (int i = 0; i < output.getNumSamples(); ++i)
+				data[i] = (SampleType)input.getSample(channel, i);
+			for (int position = 0; position < output.getNumSamples(); position += blockSize)
+				processor.processAudioBlock(data + position, juce::jmin(blockSize, output.getNumSamples() - position));
+		}
+		return output;
+	}
+
+	/* processAudioBlock() against processAudioSample() rounded to the block's sample type, which should be exact */
+	template <typename Precision, typename SampleType>
+	Error blockAgainstSample(const juce::AudioBuffer<double>& input, double sampleRate, int blockSize) {
+		auto samples = renderSamples<WDFButterLPF3<Precision>>(input, sampleRate, [](WDFButterLPF3<Precision>&) {});
+		for (int channel = 0; channel < numChannels; ++channel)
+			for (int i = 0; i < samples.getNumSamples(); ++i)
+				samples.setSample(channel, i, (double)(SampleType)samples.getSample(channel, i));
+		return compare(samples, renderBlocks<Precision, SampleType>(input, sampleRate, blockSize));
+	}
+
+	void printWrapperError(double sampleRate, const char* wrapper, const juce::String& againstSample, Error againstTunable) {
+		std::cout << juce::String((int)sampleRate).paddedLeft(' ', 7) << "  " << juce::String(wrapper).paddedRight(' ', 46)
+			<< againstSample.paddedLeft(' ', 12) << formatDb(againstTunable.relativeDb).paddedLeft(' ', 12)
+			<< formatDb(againstTunable.peakDbfs).paddedLeft(' ', 12) << std::endl;
+	}
+
+	void reportWrappers(const Options& options) {
+		std::cout << std::endl << "Tests/AnalogFilters' wrappers at " << (int)wrapperCutoff << "Hz on noise: processAudioBlock() against "
+			<< "processAudioSample() (peak dBFS), and against TunableButterLPF3 in DoublePrecision without post-warping" << std::endl << std::endl;
+		std::cout << juce::String("rate").paddedLeft(' ', 7) << "  " << juce::String("").paddedRight(' ', 46)
+			<< juce::String("block").paddedLeft(' ', 12) << juce::String("tunable dB").paddedLeft(' ', 12)
+			<< juce::String("peak dBFS").paddedLeft(' ', 12) << std::endl;
+
+		// the same circuit as WDFButterLPF3, as text and as a design
+		const juce::String netlistText = "source 600\nseries L 95.49m\nshunt C 530.5n\nseries L 95.49m\nload 600";
+		magna::wdf::LadderNetlist designed;
+		auto designResult = magna::wdf::LadderDesign::make(designed, magna::wdf::LadderDesign::Response::butterworth,
+			magna::wdf::LadderDesign::Type::lowpass, 3, wrapperCutoff);
+		jassert(designResult.wasOk());
+		juce::ignoreUnused(designResult);
+
+		for (auto sampleRate : options.sampleRates) {
+			auto noise = makeInput(false, (int)(options.seconds * sampleRate));
+			auto reference = noise;
+			render<magna::wdf::DoublePrecision>(reference, sampleRate, wrapperCutoff, options.blockSize, false);
+
+			auto samplesOnly = juce::String("-");
+			printWrapperError(sampleRate, "WDFButterLPF3<>, double blocks",
+				formatDb(blockAgainstSample<magna::wdf::DoublePrecision, double>(noise, sampleRate, options.blockSize).peakDbfs),
+				compare(reference, renderBlocks<magna::wdf::DoublePrecision, double>(noise, sampleRate, options.blockSize)));
+			printWrapperError(sampleRate, "WDFButterLPF3<>, float blocks",
+				formatDb(blockAgainstSample<magna::wdf::DoublePrecision, float>(noise, sampleRate, options.blockSize).peakDbfs),
+				compare(reference, renderBlocks<magna::wdf::DoublePrecision, float>(noise, sampleRate, options.blockSize)));
+			printWrapperError(sampleRate, "WDFButterLPF3<SinglePrecision>, float blocks",
+				formatDb(blockAgainstSample<magna::wdf::SinglePrecision, float>(noise, sampleRate, options.blockSize).peakDbfs),
+				compare(reference, renderBlocks<magna::wdf::SinglePrecision, float>(noise, sampleRate, options.blockSize)));
+			printWrapperError(sampleRate, "WDFLadder, netlist text", samplesOnly,
+				compare(reference, renderSamples<WDFLadder>(noise, sampleRate, [&netlistText](WDFLadder& ladder) { ladder.setNetlist(netlistText); })));
+			printWrapperError(sampleRate, "WDFLadder, LadderDesign Butterworth", samplesOnly,
+				compare(reference, renderSamples<WDFLadder>(noise, sampleRate, [&designed](WDFLadder& ladder) { ladder.setNetlist(designed); })));
+		}
+	}
+
+	/* float buffers with a swept cutoff, best of options.repeats */
+	template <typename Precision>
+	double nanosecondsPerSample(const Options& options, int channels) {
+		auto sampleRate = 48000.0;
+		auto numSamples = (int)(options.seconds * sampleRate);
+		auto best = 0.0;
+		for (int run = 0; run < options.repeats; ++run) {
+			juce::AudioBuffer<float> buffer(channels, numSamples);
+			juce::Random random(0x5eed);
+			for (int channel = 0; channel < channels; ++channel)
+				for (int i = 0; i < numSamples; ++i)
+					buffer.setSample(channel, i, (random.nextFloat() * 2.0f - 1.0f) * 0.5f);
+
+			auto seconds = render<Precision>(buffer, sampleRate, sweepCutoff, options.blockSize);
+			if (run == 0 || seconds < best)
+				best = seconds;
+		}
+		return best * 1.0e9 / ((double)numSamples * (double)channels);
+	}
+
+	void reportCost(const Options& options) {
+		std::cout << std::endl << "ns per channel sample at 48000Hz, swept cutoff, block " << options.blockSize << ", best of " << options.repeats
+			<< std::endl << std::endl;
+		std::cout << juce::String("channels").paddedLeft(' ', 9) << juce::String("double").paddedLeft(' ', 10)
+			<< juce::String("mixed").paddedLeft(' ', 10) << juce::String("single").paddedLeft(' ', 10) << std::endl;
+
+		for (auto channels : { 1, 2, 4, 8 }) {
+			std::cout << juce::String(channels).paddedLeft(' ', 9)
+				<< juce::String(nanosecondsPerSample<magna::wdf::DoublePrecision>(options, channels), 2).paddedLeft(' ', 10)
+				<< juce::String(nanosecondsPerSample<magna::wdf::MixedPrecision>(options, channels), 2).paddedLeft(' ', 10)
+				<< juce::String(nanosecondsPerSample<magna::wdf::SinglePrecision>(options, channels), 2).paddedLeft(' ', 10) << std::endl;
+		}
+	}
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+	juce::StringArray args;
+	for (int i = 1; i < argc; ++i)
+		args.add(argv[i]);
+
+	Options options;
+	if (args.contains("--help") || !parseOptions(args, options)) {
+		printUsage();
+		return args.contains("--help") ? 0 : 1;
+	}
+
+	std::cout << "magna::TunableButterLPF3, " << numChannels << " channels, " << options.seconds << "s per render, post-warped, block "
+		<< options.blockSize << std::endl << std::endl;
+	reportAccuracy(options);
+	reportCost(options);
+	reportWrappers(options);
+	return 0;
+}
@@ -0,0 +1,269 @@
+/*
+  ==============================================================================
+
+	Headless offline render harness for WoflmakerAudioProcessor.
+
+	Runs processBlock() outside a host on synthetic noise or a WAV file, optionally
+	automating every parameter, and reports throughput, per-block latency
+	percentiles and the real-time factor for each block size.
+
+	WOFLMakerBenchmark [--rate 48000] [--blocks 32,64,128,256,512,1024] [--seconds 10]
+	                   [--channels 2] [--input file.wav] [--output render.wav]
+	                   [--automate] [--control-rate 16] [--cubic] [--repeats 3]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../../WOFLMaker/Source/PluginProcessor.h"
+
+namespace {
+	struct Options {
+		double sampleRate = 48000.0;
+		juce::Array<int> blockSizes{ 32, 64, 128, 256, 512, 1024 };
+		double seconds = 10.0;
+		int numChannels = 2;
+		juce::File input, output;
+		bool automate = false;
+		int controlRate = 16;
+		bool cubic = false;
+		int repeats = 3;
+	};
+
+	void printUsage() {
+		std::cout << "usage: WOFLMakerBenchmark [--rate Hz] [--blocks n,n,...] [--seconds s] [--channels n]" << std::endl
+			<< "                          [--input file.wav] [--output render.wav] [--automate]" << std::endl
+			<< "                          [--control-rate n] [--cubic] [--repeats n]" << std::endl;
+	}
+
+	bool parseOptions(const juce::StringArray& args, Options& options) {
+		for (int i = 0; i < args.size(); ++i) {
+			auto& arg = args[i];
+			auto hasValue = i + 1 < args.size();
+			auto value = hasValue ? args[i + 1] : juce::String();
+
+			if (arg == "--automate")					options.automate = true;
+			else if (arg == "--cubic")					options.cubic = true;
+			else if (!hasValue)							return false;
+			else if (arg == "--rate")					options.sampleRate = value.getDoubleValue();
+			else if (arg == "--seconds")				options.seconds = value.getDoubleValue();
+			else if (arg == "--channels")				options.numChannels = value.getIntValue();
+			else if (arg == "--control-rate")			options.controlRate = value.getIntValue();
+			else if (arg == "--repeats")				options.repeats = value.getIntValue();
+			else if (arg == "--input")					options.input = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+			else if (arg == "--output")					options.output = juce::File::getCurrentWorkingDirectory().getChildFile(value);
+			else if (arg == "--blocks") {
+				options.blockSizes.clearQuick();
+				for (auto& size : juce::StringArray::fromTokens(value, ",", {}))
+					options.blockSizes.add(size.getIntValue());
+			}
+			else										return false;
+
+			if (arg != "--automate" && arg != "--cubic")
+				++i;
+		}
+
+		for (auto size : options.blockSizes)
+			if (size <= 0)
+				return false;
+		return options.sampleRate > 0.0 && options.seconds > 0.0 && options.numChannels > 0 && options.controlRate > 0
+			&& options.repeats > 0 && !options.blockSizes.isEmpty();
+	}
+
+	/* the whole test signal is rendered up front, so reading it never shows up in the timings */
+	bool loadInput(const Options& options, juce::AudioBuffer<float>& signal) {
+		auto numSamples = (int)(options.seconds * options.sampleRate);
+
+		if (options.input == juce::File()) {
+			// decorrelated white noise per channel, at -6dBFS peak
+			juce::Random random(0x5eed);
+			signal.setSize(options.numChannels, numSamples);
+			for (int channel = 0; channel < options.numChannels; ++channel) {
+				auto* data = signal.getWritePointer(channel);
+				for (int i = 0; i < numSamples; ++i)
+					data[i] = (random.nextFloat() * 2.0f - 1.0f) * 0.5f;
+			}
+			return true;
+		}
+
+		juce::AudioFormatManager formats;
+		formats.registerBasicFormats();
+		std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(options.input));
+		if (reader == nullptr) {
+			std::cerr << "can't read " << options.input.getFullPathName() << std::endl;
+			return false;
+		}
+		if (reader->sampleRate != options.sampleRate)
+			std::cout << "note: " << options.input.getFileName() << " is " << reader->sampleRate << "Hz, processed as " << options.sampleRate << "Hz" << std::endl;
+
+		// the file is looped to fill the requested length, and its channels spread over the requested channel count
+		juce::AudioBuffer<float> file((int)reader->numChannels, (int)reader->lengthInSamples);
+		reader->read(&file, 0, (int)reader->lengthInSamples, 0, true, true);
+		if (file.getNumSamples() == 0)
+			return false;
+
+		signal.setSize(options.numChannels, numSamples);
+		for (int channel = 0; channel < options.numChannels; ++channel)
+			for (int start = 0; start < numSamples; start += file.getNumSamples())
+				signal.copyFrom(channel, start, file, channel % file.getNumChannels(), 0, juce::jmin(file.getNumSamples(), numSamples - start));
+		return true;
+	}
+
+	/* every parameter follows its own slow sine (0.05Hz to 0.4Hz) through its whole range, updated once per block like host automation */
+	void automateParameters(juce::AudioProcessor& processor, int64_t position, double sampleRate) {
+		auto& parameters = processor.getParameters();
+		auto seconds = (double)position / sampleRate;
+		for (int i = 0; i < parameters.size(); ++i) {
+			auto frequency = 0.05 * (double)(i + 1);
+			auto value = 0.5 + 0.5 * std::sin(juce::MathConstants<double>::twoPi * frequency * seconds);
+			parameters[i]->setValueNotifyingHost((float)value);
+		}
+	}
+
+	struct Result {
+		double totalSeconds = 0.0;
+		juce::Array<double> blockMicroseconds; // sorted
+	};
+
+	double percentile(const juce::Array<double>& sorted, double p) {
+		if (sorted.isEmpty())
+			return 0.0;
+		auto index = juce::jlimit(0, sorted.size() - 1, (int)std::ceil(p / 100.0 * (double)sorted.size()) - 1);
+		return sorted[index];
+	}
+
+	Result render(const Options& options, int blockSize, const juce::AudioBuffer<float>& signal, juce::AudioBuffer<float>* renderOutput) {
+		WoflmakerAudioProcessor processor;
+
+		auto layout = juce::AudioChannelSet::canonicalChannelSet(options.numChannels);
+		juce::AudioProcessor::BusesLayout buses;
+		buses.inputBuses.add(layout);
+		buses.outputBuses.add(layout);
+		if (!processor.setBusesLayout(buses))
+			std::cerr << "warning: " << layout.getDescription() << " is not supported, using the default layout" << std::endl;
+
+		processor.setModulationControlRate(options.controlRate);
+		processor.setModulationInterpolation(options.cubic ? WoflmakerControlRateLFO::Interpolation::cubic : WoflmakerControlRateLFO::Interpolation::linear);
+		processor.setRateAndBufferSizeDetails(options.sampleRate, blockSize);
+		processor.prepareToPlay(options.sampleRate, blockSize);
+
+		// without --automate, the LFOs are still switched on so the modulation path is measured
+		if (!options.automate) {
+			for (auto* parameter : processor.getParameters()) {
+				if (auto* p = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter)) {
+					if (p->paramID == "width")				p->setValueNotifyingHost(0.75f);
+					else if (p->paramID == "centerLFO")		p->setValueNotifyingHost(0.05f);
+					else if (p->paramID == "widthLFO")		p->setValueNotifyingHost(0.02f);
+					else if (p->paramID == "centerLFOToggle")	p->setValueNotifyingHost(1.0f);
+				}
+			}
+		}
+
+		auto numChannels = juce::jmax(processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels());
+		juce::AudioBuffer<float> block(numChannels, blockSize);
+		juce::MidiBuffer midi;
+
+		Result result;
+		auto numBlocks = (signal.getNumSamples() + blockSize - 1) / blockSize;
+		result.blockMicroseconds.ensureStorageAllocated(numBlocks);
+
+		for (int64_t position = 0; position < signal.getNumSamples(); position += blockSize) {
+			auto numSamples = (int)juce::jmin((int64_t)blockSize, (int64_t)signal.getNumSamples() - position);
+			block.setSize(numChannels, numSamples, false, false, true);
+			for (int channel = 0; channel < numChannels; ++channel)
+				block.copyFrom(channel, 0, signal, channel % signal.getNumChannels(), (int)position, numSamples);
+
+			if (options.automate)
+				automateParameters(processor, position, options.sampleRate);
+
+			auto startTicks = juce::Time::getHighResolutionTicks();
+			processor.processBlock(block, midi);
+			auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+			result.totalSeconds += elapsed;
+			result.blockMicroseconds.add(elapsed * 1.0e6);
+
+			if (renderOutput != nullptr)
+				for (int channel = 0; channel < juce::jmin(numChannels, renderOutput->getNumChannels()); ++channel)
+					renderOutput->copyFrom(channel, (int)position, block, channel, 0, numSamples);
+		}
+
+		processor.releaseResources();
+		result.blockMicroseconds.sort();
+		return result;
+	}
+
+	bool writeOutput(const juce::File& file, const juce::AudioBuffer<float>& buffer, double sampleRate) {
+		file.deleteFile();
+		std::unique_ptr<juce::FileOutputStream> stream(file.createOutputStream());
+		if (stream == nullptr)
+			return false;
+
+		juce::WavAudioFormat wav;
+		std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate, (unsigned int)buffer.getNumChannels(), 24, {}, 0));
+		if (writer == nullptr)
+			return false;
+		stream.release(); // now owned by the writer
+		return writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+	}
+}
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+	juce::ScopedJuceInitialiser_GUI juceInitialiser; // parameters and the APVTS expect a message manager
+
+	juce::StringArray args;
+	for (int i = 1; i < argc; ++i)
+		args.add(argv[i]);
+
+	Options options;
+	if (args.contains("--help") || !parseOptions(args, options)) {
+		printUsage();
+		return args.contains("--help") ? 0 : 1;
+	}
+
+	juce::AudioBuffer<float> signal;
+	if (!loadInput(options, signal))
+		return 1;
+
+	auto audioSeconds = (double)signal.getNumSamples() / options.sampleRate;
+	std::cout << "WOFLMaker, " << options.numChannels << " channels at " << options.sampleRate << "Hz, " << audioSeconds << "s of audio, "
+		<< (options.automate ? "automated" : "static") << " parameters, LFO control rate 1/" << options.controlRate
+		<< (options.cubic ? " (cubic)" : " (linear)") << ", best of " << options.repeats << std::endl << std::endl;
+	std::cout << juce::String("block").paddedLeft(' ', 6) << juce::String("Msamples/s").paddedLeft(' ', 12) << juce::String("x realtime").paddedLeft(' ', 12)
+		<< juce::String("p50 us").paddedLeft(' ', 10) << juce::String("p90 us").paddedLeft(' ', 10) << juce::String("p99 us").paddedLeft(' ', 10)
+		<< juce::String("p99.9 us").paddedLeft(' ', 10) << juce::String("max us").paddedLeft(' ', 10) << std::endl;
+
+	for (auto blockSize : options.blockSizes) {
+		// the fastest run is reported: slower ones only measure interference from the rest of the system
+		Result best;
+		for (int run = 0; run < options.repeats; ++run) {
+			auto result = render(options, blockSize, signal, nullptr);
+			if (run == 0 || result.totalSeconds < best.totalSeconds)
+				best = result;
+		}
+
+		auto samplesPerSecond = (double)signal.getNumSamples() / best.totalSeconds;
+		std::cout << juce::String(blockSize).paddedLeft(' ', 6)
+			<< juce::String(samplesPerSecond * 1.0e-6, 2).paddedLeft(' ', 12)
+			<< juce::String(audioSeconds / best.totalSeconds, 1).paddedLeft(' ', 12)
+			<< juce::String(percentile(best.blockMicroseconds, 50.0), 2).paddedLeft(' ', 10)
+			<< juce::String(percentile(best.blockMicroseconds, 90.0), 2).paddedLeft(' ', 10)
+			<< juce::String(percentile(best.blockMicroseconds, 99.0), 2).paddedLeft(' ', 10)
+			<< juce::String(percentile(best.blockMicroseconds, 99.9), 2).paddedLeft(' ', 10)
+			<< juce::String(best.blockMicroseconds.getLast(), 2).paddedLeft(' ', 10) << std::endl;
+	}
+
+	if (options.output != juce::File()) {
+		juce::AudioBuffer<float> rendered(options.numChannels, signal.getNumSamples());
+		render(options, options.blockSizes.getFirst(), signal, &rendered);
+		if (!writeOutput(options.output, rendered, options.sampleRate)) {
+			std::cerr << "can't write " << options.output.getFullPathName() << std::endl;
+			return 1;
+		}
+		std::cout << std::endl << "rendered " << options.output.getFullPathName() << std::endl;
+	}
+
+	return 0;
+}
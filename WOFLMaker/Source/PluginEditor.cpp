@@ -47,7 +47,9 @@ WoflmakerAudioProcessorEditor::WoflmakerAudioProcessorEditor (WoflmakerAudioProc
     addAndMakeVisible(&panCenterLFOToggleButton);
 
     // Drop-down menu to select LFO function
-    // TODO
+    panCenterLFOFunctionMenu.addItemList(WoflmakerLFOWavetableBank::getShapeNames(), 1);
+    panCenterLFOFunctionMenuAttachment.sendInitialUpdate(); // the attachment was created before the menu had any items
+    addAndMakeVisible(panCenterLFOFunctionMenu);
 
     // Component boxes: to add titles to sliders and simplify placement in window
     panCenterSliderBox.boxTitle.setText("Pan Center", juce::NotificationType::dontSendNotification);
@@ -143,9 +145,11 @@ void WoflmakerAudioProcessorEditor::LFOControlBox::resized() {
 
     auto toggleButtonHeight = 20;
     auto toggleButtonWidth = 60;
+    auto dropDownMenuWidth = 120;
     auto lfoWindowHeight = height * WOFL_LFO_WINDOW_HEIGHT_AS_PROPORTION_OF_CONTROLBOX_HEIGHT;
 
     toggleButton.setBounds(getX(), getY(), toggleButtonWidth, toggleButtonHeight);
+    dropDownMenu.setBounds(getX() + toggleButtonWidth, getY(), dropDownMenuWidth, toggleButtonHeight);
     area.removeFromTop(toggleButtonHeight);
     area.removeFromBottom(lfoWindowHeight); // lfoWindow.setBounds(area.removeFromBottom(lfoWindowHeight).reduced(WOFL_CONTROLBOX_SPACE_LFO_WINDOW_REDUCTION_FACTOR));
 
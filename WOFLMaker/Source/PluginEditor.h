@@ -17,8 +17,6 @@
 #include "../../MyJUCEFiles/Component.h"
 #include "../../MyJUCEFiles/ComponentBox.h"
 
-#define NUM_LFO_FUNCTIONS 4
-
 //==============================================================================
 /**
 */
@@ -7,7 +7,9 @@
 */
 
 #include "PluginProcessor.h"
+#if ! WOFL_HEADLESS
 #include "PluginEditor.h"
+#endif
 
 //==============================================================================
 WoflmakerAudioProcessor::WoflmakerAudioProcessor()
@@ -29,12 +31,18 @@ WoflmakerAudioProcessor::WoflmakerAudioProcessor()
 	addParameter(panCenterLFOToggleParameter = new juce::AudioParameterBool("centerLFOToggle", "Pan Center LFO Toggle", false));
 	addParameter(panCenterLFOFunctionMenuChoiceParameter = new juce::AudioParameterInt("centerLFOFunction", "Pan Center LFO Function",0, NUM_LFO_FUNCTIONS-1, 0));
 
-	panCenterLFO.initialise([](float x) { return std::sin(x); }, 128);
-	panCenterLFO.setFrequency(panCenterLFOParameter->get());
+	for (auto* parameter : getParameters())
+		parameter->addListener(this);
+
+	// the pan center LFO swings by the (modulated) width around the pan center; the pan width LFO breathes the width itself
+	panCenterLFORoute = modulationMatrix.addRoute(WoflmakerModulationMatrix::panCenterLFOSource, WoflmakerModulationMatrix::panCenterTarget, WoflmakerModulationMatrix::panWidthTarget);
+	panWidthLFORoute = modulationMatrix.addRoute(WoflmakerModulationMatrix::panWidthLFOSource, WoflmakerModulationMatrix::panWidthTarget);
 }
 
 WoflmakerAudioProcessor::~WoflmakerAudioProcessor()
 {
+	for (auto* parameter : getParameters())
+		parameter->removeListener(this);
 }
 
 //==============================================================================
@@ -105,9 +113,20 @@ void WoflmakerAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlo
 	// Use this method as the place to do any pre-playback
 	// initialisation that you need...
 
-	// may want set to getNumOutputChannels() instead
-	juce::dsp::ProcessSpec lfoSpec = { sampleRate / (double)lfoUpdateRate, (juce::uint32)samplesPerBlock, (juce::uint32)getTotalNumInputChannels() };
-	panCenterLFO.prepare(lfoSpec);
+	auto controlRate = modulationControlRate.load();
+	panCenterLFO.prepare(sampleRate, controlRate);
+	panWidthLFO.prepare(sampleRate, controlRate);
+
+	modulationMatrix.prepare(sampleRate, samplesPerBlock);
+	panEngine.prepare(samplesPerBlock);
+
+	auto outputLayout = getChannelLayoutOfBus(false, 0);
+	useSurroundPanner = WoflmakerSurroundPanner::isLayoutSupported(outputLayout);
+	if (useSurroundPanner)
+		surroundPanner.prepare(outputLayout, samplesPerBlock);
+
+	// force a fresh snapshot on the first block
+	snapshotVersion = parameterVersion.load() - 1;
 }
 
 void WoflmakerAudioProcessor::releaseResources()
@@ -123,10 +142,10 @@ bool WoflmakerAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts)
 	juce::ignoreUnused(layouts);
 	return true;
 #else
-	// This is the place where you check if the layout is supported.
-	// In this template code we only support mono or stereo.
+	// mono and stereo go through the stereo pan law, anything bigger (quad, 5.1, 7.1, discrete rings, ambisonics...) through the surround panner
 	if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-		&& layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+		&& layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo()
+		&& !WoflmakerSurroundPanner::isLayoutSupported(layouts.getMainOutputChannelSet()))
 		return false;
 
 	// This checks if the input layout matches the output layout
@@ -156,82 +175,180 @@ void WoflmakerAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juc
 	for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
 		buffer.clear(i, 0, numSamples);
 
-	float gainL, gainR;
+	updateParameterSnapshot();
 
-	// update LFO frequency based on pan center LFO slider value
-	panCenterLFO.setFrequency(panCenterLFOParameter->get()); // force?
+	// hosts may send blocks larger than the size given to prepareToPlay(), so work through the buffer in sub-blocks the pan engine can hold
+	for (int start = 0; start < numSamples; start += panEngine.getMaximumBlockSize()) {
+		auto subBlockSize = juce::jmin(panEngine.getMaximumBlockSize(), numSamples - start);
 
-	// first, get the offset of the pan from the pan-center slider. This is independent of whether the LFO is toggled ON
-	float panOscCurrentValue = (float)panCenterParameter->get();
-	// Then, IF the LFO is toggled ON, add the current value of oscillation
-	if (panCenterLFOToggleParameter->get()) {
-		// LFO amplitude is 1 --> to re-map it to the amplitude requested by the GUI we simply multiply by the value of the width slider (attached to panWidthParameter)
-		panOscCurrentValue += panCenterLFO.processSample(0.0f) * panWidthParameter->get();
-	}
-	// Divide to re-map to a {-1.0, 1.0} space
-	panOscCurrentValue /= (float)PAN_MAX_MAGNITUDE;
+		// sources that no route currently uses are not rendered (their phase holds until they are turned back on)
+		if (modulationMatrix.isSourceActive(WoflmakerModulationMatrix::panWidthLFOSource))
+			panWidthLFO.process(modulationMatrix.getSourceRow(WoflmakerModulationMatrix::panWidthLFOSource), subBlockSize);
+		if (modulationMatrix.isSourceActive(WoflmakerModulationMatrix::panCenterLFOSource))
+			panCenterLFO.process(modulationMatrix.getSourceRow(WoflmakerModulationMatrix::panCenterLFOSource), subBlockSize);
 
-	// channel gains
-	auto p = juce::MathConstants<float>::halfPi * 0.5 * (panOscCurrentValue + 1.0);
-	gainL = std::cos(p);
-	gainR = std::sin(p);
+		modulationMatrix.process(subBlockSize);
 
-	// left channel
-	if (gainL == previousGainL) {
-		buffer.applyGain(0, 0, numSamples, gainL);
-	}
-	else {
-		buffer.applyGainRamp(0, 0, numSamples, previousGainL, gainL);
-		previousGainL = gainL;
+		juce::FloatVectorOperations::copy(panEngine.getPanTrajectory(), modulationMatrix.getTargetRow(WoflmakerModulationMatrix::panCenterTarget), subBlockSize);
+		if (useSurroundPanner)
+			surroundPanner.process(buffer, panEngine.getPanTrajectory(), start, subBlockSize);
+		else
+			panEngine.process(buffer, start, subBlockSize);
 	}
+}
 
-	// gainR
-	if (totalNumInputChannels > 1) {
-		if (gainR == previousGainR) {
-			buffer.applyGain(1, 0, numSamples, gainR);
-		}
-		else {
-			buffer.applyGainRamp(1, 0, numSamples, previousGainR, gainR);
-			previousGainR = gainR;
-		}
-	}
+void WoflmakerAudioProcessor::parameterValueChanged(int, float) {
+	parameterVersion.fetch_add(1, std::memory_order_release);
+}
+
+void WoflmakerAudioProcessor::updateParameterSnapshot() noexcept {
+	// read the version before the values: a change that lands while copying bumps the version again and gets picked up next block
+	auto version = parameterVersion.load(std::memory_order_acquire);
+	if (version == snapshotVersion)
+		return;
+	snapshotVersion = version;
+
+	parameters.panCenter = panCenterParameter->get();
+	parameters.panWidth = panWidthParameter->get();
+	parameters.panCenterLFOFunction = panCenterLFOFunctionMenuChoiceParameter->get();
+	parameters.panCenterLFORate = panCenterLFOParameter->get();
+	parameters.panWidthLFORate = panWidthLFOParameter->get();
+	parameters.panCenterLFOEnabled = panCenterLFOToggleParameter->get();
+
+	// update LFO frequencies based on the LFO slider values
+	panCenterLFO.setFrequency(parameters.panCenterLFORate);
+	panWidthLFO.setFrequency(parameters.panWidthLFORate);
+	setLFOFunction(panCenterLFO, parameters.panCenterLFOFunction);
+	panCenterLFO.setInterpolation((WoflmakerControlRateLFO::Interpolation)modulationInterpolation.load());
+	panWidthLFO.setInterpolation((WoflmakerControlRateLFO::Interpolation)modulationInterpolation.load());
+
+	// all modulation values are re-mapped to a {-1.0, 1.0} space
+	auto panWidth = (float)parameters.panWidth / (float)PAN_MAX_MAGNITUDE;
+	auto widthLFOEnabled = parameters.panWidthLFORate > 0.0f;
+
+	// first, get the offset of the pan from the pan-center slider. This is independent of whether the LFO is toggled ON
+	modulationMatrix.setBase(WoflmakerModulationMatrix::panCenterTarget, (float)parameters.panCenter / (float)PAN_MAX_MAGNITUDE);
+	// LFO amplitude is 1 --> to re-map it to the amplitude requested by the GUI the pan center LFO is scaled by the width target
+	modulationMatrix.setRouteAmount(panCenterLFORoute, parameters.panCenterLFOEnabled ? 1.0f : 0.0f);
+	// when its rate is above 0, the width LFO sweeps the width between 0 and the width slider value
+	modulationMatrix.setBase(WoflmakerModulationMatrix::panWidthTarget, widthLFOEnabled ? 0.5f * panWidth : panWidth);
+	modulationMatrix.setRouteAmount(panWidthLFORoute, widthLFOEnabled ? 0.5f * panWidth : 0.0f);
 }
 
 //==============================================================================
 bool WoflmakerAudioProcessor::hasEditor() const
 {
+#if WOFL_HEADLESS
+	return false;
+#else
 	return true; // (change this to false if you choose to not supply an editor)
+#endif
 }
 
 juce::AudioProcessorEditor* WoflmakerAudioProcessor::createEditor()
 {
+#if WOFL_HEADLESS
+	return nullptr;
+#else
 	return new WoflmakerAudioProcessorEditor(*this, tree, panCenterParameter, panWidthParameter, panCenterLFOParameter, panWidthLFOParameter, panCenterLFOToggleParameter, panCenterLFOFunctionMenuChoiceParameter);
+#endif
 }
 
 //==============================================================================
+/* Binary state, little-endian:
+	int32 stateMagic, int32 stateVersion,
+	int32 pan center, int32 pan width, float pan center LFO rate, float pan width LFO rate, int8 pan center LFO toggle, int32 pan center LFO function,
+	float pan center LFO phase, float pan width LFO phase
+New versions may only append fields, so a reader can always stop after the ones it knows */
+namespace {
+	const int stateMagic = 0x4c464f57; // "WOFL"
+	const int stateVersion = 1;
+	const int stateVersion1PayloadSize = 6 * 4 + 1 + 4;
+	const char* stateXmlTag = "WOFLMAKER";
+}
+
 void WoflmakerAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-	// You should use this method to store your parameters in the memory block.
-	// You could do that either as raw data, or use the XML or ValueTree classes
-	// as intermediaries to make it easy to save and load complex data.
+#if WOFL_SAVE_STATE_AS_XML
+	juce::XmlElement xml(stateXmlTag);
+	xml.setAttribute("version", stateVersion);
+	xml.setAttribute(panCenterParameter->paramID, panCenterParameter->get());
+	xml.setAttribute(panWidthParameter->paramID, panWidthParameter->get());
+	xml.setAttribute(panCenterLFOParameter->paramID, panCenterLFOParameter->get());
+	xml.setAttribute(panWidthLFOParameter->paramID, panWidthLFOParameter->get());
+	xml.setAttribute(panCenterLFOToggleParameter->paramID, panCenterLFOToggleParameter->get());
+	xml.setAttribute(panCenterLFOFunctionMenuChoiceParameter->paramID, panCenterLFOFunctionMenuChoiceParameter->get());
+	xml.setAttribute("centerLFOPhase", panCenterLFO.getPhase());
+	xml.setAttribute("widthLFOPhase", panWidthLFO.getPhase());
+	copyXmlToBinary(xml, destData);
+#else
+	juce::MemoryOutputStream stream(destData, false);
+	stream.writeInt(stateMagic);
+	stream.writeInt(stateVersion);
+	stream.writeInt(panCenterParameter->get());
+	stream.writeInt(panWidthParameter->get());
+	stream.writeFloat(panCenterLFOParameter->get());
+	stream.writeFloat(panWidthLFOParameter->get());
+	stream.writeByte(panCenterLFOToggleParameter->get() ? 1 : 0);
+	stream.writeInt(panCenterLFOFunctionMenuChoiceParameter->get());
+	stream.writeFloat(panCenterLFO.getPhase());
+	stream.writeFloat(panWidthLFO.getPhase());
+#endif
 }
 
 void WoflmakerAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
-	// You should use this method to restore your parameters from this memory block,
-	// whose contents will have been created by the getStateInformation() call.
-}
+	juce::MemoryInputStream stream(data, (size_t)juce::jmax(0, sizeInBytes), false);
+
+	if (sizeInBytes >= 8 && stream.readInt() == stateMagic) {
+		auto version = stream.readInt();
+		if (version < 1 || stream.getNumBytesRemaining() < stateVersion1PayloadSize) {
+			jassertfalse; // corrupt or truncated state
+			return;
+		}
+
+		*panCenterParameter = stream.readInt();
+		*panWidthParameter = stream.readInt();
+		*panCenterLFOParameter = stream.readFloat();
+		*panWidthLFOParameter = stream.readFloat();
+		*panCenterLFOToggleParameter = stream.readByte() != 0;
+		*panCenterLFOFunctionMenuChoiceParameter = stream.readInt();
+		panCenterLFO.setPhase(stream.readFloat());
+		panWidthLFO.setPhase(stream.readFloat());
+		return;
+	}
 
-void WoflmakerAudioProcessor::setLFOFunction(juce::dsp::Oscillator<float>& lfo, int function) {
-	switch (function) {
-	/* the function passed to initialise() is expected to be mapped to a periodic input between (-pi...pi). */
-	/* for non-trig functions, to map to range (-1.0...1.0) simply have to divide x by pi */
-	default: // sine
-		lfo.initialise([](float x) {return std::sin(x); }, 128);
-		break;
+	// XML fallback, for states saved with WOFL_SAVE_STATE_AS_XML
+	if (auto xml = getXmlFromBinary(data, sizeInBytes)) {
+		if (!xml->hasTagName(stateXmlTag))
+			return;
+
+		*panCenterParameter = xml->getIntAttribute(panCenterParameter->paramID, panCenterParameter->get());
+		*panWidthParameter = xml->getIntAttribute(panWidthParameter->paramID, panWidthParameter->get());
+		*panCenterLFOParameter = (float)xml->getDoubleAttribute(panCenterLFOParameter->paramID, panCenterLFOParameter->get());
+		*panWidthLFOParameter = (float)xml->getDoubleAttribute(panWidthLFOParameter->paramID, panWidthLFOParameter->get());
+		*panCenterLFOToggleParameter = xml->getBoolAttribute(panCenterLFOToggleParameter->paramID, panCenterLFOToggleParameter->get());
+		*panCenterLFOFunctionMenuChoiceParameter = xml->getIntAttribute(panCenterLFOFunctionMenuChoiceParameter->paramID, panCenterLFOFunctionMenuChoiceParameter->get());
+		panCenterLFO.setPhase((float)xml->getDoubleAttribute("centerLFOPhase"));
+		panWidthLFO.setPhase((float)xml->getDoubleAttribute("widthLFOPhase"));
 	}
 }
 
+void WoflmakerAudioProcessor::setModulationControlRate(int decimationFactor) {
+	jassert(decimationFactor > 0);
+	modulationControlRate = juce::jmax(1, decimationFactor);
+}
+
+void WoflmakerAudioProcessor::setModulationInterpolation(WoflmakerControlRateLFO::Interpolation interpolation) {
+	modulationInterpolation = (int)interpolation;
+	parameterVersion.fetch_add(1, std::memory_order_release);
+}
+
+void WoflmakerAudioProcessor::setLFOFunction(WoflmakerControlRateLFO& lfo, int function) {
+	// the wavetables are built once when the bank is first created, so switching shape is a single atomic store and safe on the audio thread
+	lfo.setShape(function);
+}
+
 //==============================================================================
 // This creates new instances of the plugin..
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
@@ -10,13 +10,24 @@
 
 #include <JuceHeader.h>
 #include "../../MyJUCEFiles/RotarySliders.h" // for PAN_MAX_MAGNITUDE
+#include "WoflmakerPanEngine.h"
+#include "WoflmakerSurroundPanner.h"
+#include "WoflmakerModulation.h"
 
 #define MAX_LFO_FREQUENCY_HZ 60
 
+/* set to 1 to save the plugin state as XML instead of the compact binary format (handy for debugging). Both formats can always be loaded */
+#define WOFL_SAVE_STATE_AS_XML 0
+
+/* defined as 1 by the headless benchmark project (Tests/WOFLMakerBenchmark), which builds the processor without the editor or its binary resources */
+#ifndef WOFL_HEADLESS
+#define WOFL_HEADLESS 0
+#endif
+
 //==============================================================================
 /**
 */
-class WoflmakerAudioProcessor : public juce::AudioProcessor
+class WoflmakerAudioProcessor : public juce::AudioProcessor, private juce::AudioProcessorParameter::Listener
 {
 public:
 	//==============================================================================
@@ -56,25 +67,56 @@ public:
 	void getStateInformation(juce::MemoryBlock& destData) override;
 	void setStateInformation(const void* data, int sizeInBytes) override;
 
+	/* Number of samples between LFO evaluations (the LFO decimation factor); the LFOs are interpolated back up to audio rate in between.
+	1 = the LFOs are evaluated every sample. Takes effect on the next call to prepareToPlay() */
+	void setModulationControlRate(int decimationFactor);
+
+	/* How the LFOs are interpolated between control points. Takes effect on the next processed block */
+	void setModulationInterpolation(WoflmakerControlRateLFO::Interpolation interpolation);
+
 private:
 	//==============================================================================
 	juce::AudioProcessorValueTreeState tree;
 
-	// Tracking previous states
-	float previousGainL = 1.0;
-	float previousGainR = 1.0;
-
 	// LFOs
-	juce::dsp::Oscillator<float> panCenterLFO, panWidthLFO;
-	static constexpr size_t lfoUpdateRate = 100;
-	size_t lfoUpdateCounter = lfoUpdateRate;
+	WoflmakerControlRateLFO panCenterLFO, panWidthLFO;
+
+	// LFOs -> pan center / pan width
+	WoflmakerModulationMatrix modulationMatrix;
+	int panCenterLFORoute, panWidthLFORoute;
+	std::atomic<int> modulationControlRate{ 16 }; // LFO decimation factor, applied in prepareToPlay()
+	std::atomic<int> modulationInterpolation{ (int)WoflmakerControlRateLFO::Interpolation::linear };
+
+	// Pan law
+	WoflmakerPanEngine panEngine;
+	WoflmakerSurroundPanner surroundPanner; // used instead of the pan engine for layouts bigger than stereo
+	bool useSurroundPanner = false;
 
 	// Processor parameters
 	juce::AudioParameterInt* panCenterParameter, * panWidthParameter, * panCenterLFOFunctionMenuChoiceParameter;
 	juce::AudioParameterFloat* panCenterLFOParameter, * panWidthLFOParameter;
 	juce::AudioParameterBool* panCenterLFOToggleParameter;
 
-	void setLFOFunction(juce::dsp::Oscillator<float>& lfo, int function);
+	/* Plain copy of every parameter, taken by the audio thread only when parameterVersion has moved since the last copy */
+	struct ParameterSnapshot {
+		int panCenter = 0, panWidth = 0, panCenterLFOFunction = 0;
+		float panCenterLFORate = 0.0f, panWidthLFORate = 0.0f;
+		bool panCenterLFOEnabled = false;
+	};
+	ParameterSnapshot parameters;
+
+	// bumped by parameterValueChanged() (from whichever thread changed the parameter), compared against once per block
+	std::atomic<juce::uint32> parameterVersion{ 1 };
+	juce::uint32 snapshotVersion = 0;
+
+	void parameterValueChanged(int parameterIndex, float newValue) override;
+	void parameterGestureChanged(int, bool) override {}
+
+	/* re-reads the parameters and recomputes everything derived from them, if anything changed. Audio thread only */
+	void updateParameterSnapshot() noexcept;
+
+	/* function is one of WoflmakerLFOWavetableBank::Shape */
+	void setLFOFunction(WoflmakerControlRateLFO& lfo, int function);
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WoflmakerAudioProcessor)
 };
@@ -0,0 +1,87 @@
+#include "WoflmakerLFOWavetables.h"
+
+WoflmakerLFOWavetableBank::WoflmakerLFOWavetableBank() {
+	auto fill = [](std::vector<float>& table, int size, std::function<float(float)> f) {
+		table.resize((size_t)size);
+		for (int i = 0; i < size; ++i)
+			table[(size_t)i] = f((float)i / (float)size);
+	};
+
+	/* every shape is mapped so that x = 0.0 starts at zero and rising, like the sine */
+	fill(tables[sine], tableSize, [](float x) { return std::sin(juce::MathConstants<float>::twoPi * x); });
+	fill(tables[triangle], tableSize, [](float x) {
+		auto t = x + 0.25f;
+		t -= std::floor(t);
+		return 1.0f - 4.0f * std::abs(t - 0.5f);
+	});
+	fill(tables[saw], tableSize, [](float x) {
+		auto t = x + 0.5f;
+		return 2.0f * (t - std::floor(t)) - 1.0f;
+	});
+	fill(tables[square], tableSize, [](float x) { return x < 0.5f ? 1.0f : -1.0f; });
+
+	// fixed seed, so every instance (and every session) gets the same sequence
+	juce::Random random(0x0f1);
+	float steps[sampleAndHoldSteps];
+	for (auto& step : steps)
+		step = random.nextFloat() * 2.0f - 1.0f;
+	fill(tables[sampleAndHold], sampleAndHoldTableSize, [&steps](float x) { return steps[juce::jmin((int)(x * (float)sampleAndHoldSteps), sampleAndHoldSteps - 1)]; });
+
+	for (int shape = triangle; shape < NUM_LFO_FUNCTIONS; ++shape)
+		bandLimit(tables[shape], maxHarmonicsPerCycle * getCyclesPerTable(shape));
+
+	// guard point
+	for (auto& table : tables)
+		table.push_back(table.front());
+}
+
+float WoflmakerLFOWavetableBank::lookup(int shape, float phase) const noexcept {
+	jassert(shape >= 0 && shape < NUM_LFO_FUNCTIONS);
+	const auto& table = tables[shape];
+	auto position = phase * (float)(table.size() - 1);
+	auto index = juce::jlimit(0, (int)table.size() - 2, (int)position);
+	auto fraction = position - (float)index;
+	return table[(size_t)index] + fraction * (table[(size_t)index + 1] - table[(size_t)index]);
+}
+
+/* Removes every harmonic above maxHarmonic by projecting the table onto its first maxHarmonic Fourier components. The components are
+weighted with Lanczos sigma factors so the truncation doesn't leave Gibbs overshoot (which would push the pan past its limits) */
+void WoflmakerLFOWavetableBank::bandLimit(std::vector<float>& table, int maxHarmonic) {
+	const auto size = (int)table.size();
+	maxHarmonic = juce::jmin(maxHarmonic, size / 2 - 1);
+
+	std::vector<double> cosine((size_t)size), output((size_t)size, 0.0);
+	for (int n = 0; n < size; ++n)
+		cosine[(size_t)n] = std::cos(juce::MathConstants<double>::twoPi * (double)n / (double)size);
+
+	double mean = 0.0;
+	for (auto x : table)
+		mean += x;
+	mean /= (double)size;
+
+	for (int k = 1; k <= maxHarmonic; ++k) {
+		double a = 0.0, b = 0.0;
+		// sin(2 pi k n / N) == cos(2 pi (k n - N/4) / N)
+		for (int n = 0; n < size; ++n) {
+			a += table[(size_t)n] * cosine[(size_t)((k * n) % size)];
+			b += table[(size_t)n] * cosine[(size_t)((k * n - size / 4 + size) % size)];
+		}
+
+		auto sigmaArgument = juce::MathConstants<double>::pi * (double)k / (double)(maxHarmonic + 1);
+		auto sigma = std::sin(sigmaArgument) / sigmaArgument;
+		a *= 2.0 * sigma / (double)size;
+		b *= 2.0 * sigma / (double)size;
+
+		for (int n = 0; n < size; ++n)
+			output[(size_t)n] += a * cosine[(size_t)((k * n) % size)] + b * cosine[(size_t)((k * n - size / 4 + size) % size)];
+	}
+
+	double peak = 0.0;
+	for (int n = 0; n < size; ++n) {
+		output[(size_t)n] += mean;
+		peak = juce::jmax(peak, std::abs(output[(size_t)n]));
+	}
+
+	for (int n = 0; n < size; ++n)
+		table[(size_t)n] = (float)(peak > 0.0 ? output[(size_t)n] / peak : 0.0);
+}
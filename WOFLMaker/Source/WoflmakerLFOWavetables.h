@@ -0,0 +1,40 @@
+#ifndef WOFLMAKERLFOWAVETABLES_H
+#define WOFLMAKERLFOWAVETABLES_H
+
+#include <JuceHeader.h>
+
+#define NUM_LFO_FUNCTIONS 5
+
+/* Precomputed, band-limited LFO waveforms (sine, triangle, saw, square, sample-and-hold). The tables are built once in the constructor
+and never change afterwards, so the audio thread can switch between them by index without locking or allocating.
+Hold it through a juce::SharedResourcePointer so every plugin instance in the process shares one bank */
+class WoflmakerLFOWavetableBank {
+public:
+	enum Shape { sine = 0, triangle, saw, square, sampleAndHold };
+
+	WoflmakerLFOWavetableBank();
+
+	/* how many LFO cycles one pass through the table covers. 1 for the periodic shapes; the sample-and-hold table holds
+	several random steps (one per LFO cycle), so it is read that many times slower */
+	int getCyclesPerTable(int shape) const noexcept { return shape == sampleAndHold ? sampleAndHoldSteps : 1; }
+
+	/* linearly interpolated table read. phase is the position in the table, in the range {0.0, 1.0} */
+	float lookup(int shape, float phase) const noexcept;
+
+	static juce::StringArray getShapeNames() { return { "Sine", "Triangle", "Saw", "Square", "Sample & Hold" }; }
+
+private:
+	static constexpr int tableSize = 2048;
+	static constexpr int sampleAndHoldTableSize = 4096;
+	static constexpr int sampleAndHoldSteps = 32;
+	static constexpr int maxHarmonicsPerCycle = 16; // keeps a MAX_LFO_FREQUENCY_HZ LFO below Nyquist at control rates down to ~2kHz
+
+	// every table carries one guard point past the end so lookup() never has to wrap
+	std::vector<float> tables[NUM_LFO_FUNCTIONS];
+
+	static void bandLimit(std::vector<float>& table, int maxHarmonic);
+
+	JUCE_DECLARE_NON_COPYABLE(WoflmakerLFOWavetableBank)
+};
+
+#endif
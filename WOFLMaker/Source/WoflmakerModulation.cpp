@@ -0,0 +1,137 @@
+#include "WoflmakerModulation.h"
+
+void WoflmakerControlRateLFO::prepare(double sampleRate, int decimationFactor) {
+	jassert(decimationFactor > 0);
+	decimation = juce::jmax(1, decimationFactor);
+	inverseDecimation = 1.0f / (float)decimation;
+
+	// the table is only read once per control point, so phase increments (and frequency smoothing) are in control-rate units
+	controlRate = (float)(sampleRate / (double)decimation);
+	frequency.reset((double)controlRate, 0.05);
+	reset();
+}
+
+void WoflmakerControlRateLFO::reset() noexcept {
+	phase = 0.0f;
+	publishedPhase.store(0.0f, std::memory_order_relaxed);
+	frequency.setCurrentAndTargetValue(frequency.getTargetValue());
+	std::fill(std::begin(controlPoints), std::end(controlPoints), 0.0f);
+	std::fill(std::begin(coefficients), std::end(coefficients), 0.0f);
+	samplesUntilNextControlPoint = 0;
+	step = 0;
+}
+
+void WoflmakerControlRateLFO::process(float* destination, int numSamples) noexcept {
+	auto newPhase = requestedPhase.exchange(-1.0f, std::memory_order_relaxed);
+	if (newPhase >= 0.0f)
+		phase = newPhase;
+
+	int i = 0;
+	while (i < numSamples) {
+		if (samplesUntilNextControlPoint == 0)
+			advanceControlPoint();
+
+		auto runLength = juce::jmin(samplesUntilNextControlPoint, numSamples - i);
+		// linear interpolation is the same polynomial with coefficients[2] = coefficients[3] = 0, so both modes share one loop
+		for (int k = 0; k < runLength; ++k) {
+			auto t = (float)(step + k) * inverseDecimation;
+			destination[i + k] = ((coefficients[3] * t + coefficients[2]) * t + coefficients[1]) * t + coefficients[0];
+		}
+
+		i += runLength;
+		step += runLength;
+		samplesUntilNextControlPoint -= runLength;
+	}
+}
+
+void WoflmakerControlRateLFO::advanceControlPoint() noexcept {
+	controlPoints[0] = controlPoints[1];
+	controlPoints[1] = controlPoints[2];
+	controlPoints[2] = controlPoints[3];
+	auto currentShape = shape.load(std::memory_order_relaxed);
+	controlPoints[3] = wavetables->lookup(currentShape, phase);
+	phase += frequency.getNextValue() / (controlRate * (float)wavetables->getCyclesPerTable(currentShape));
+	phase -= std::floor(phase);
+	publishedPhase.store(phase, std::memory_order_relaxed);
+
+	auto p0 = controlPoints[0], p1 = controlPoints[1], p2 = controlPoints[2], p3 = controlPoints[3];
+	coefficients[0] = p1;
+
+	if (interpolation == Interpolation::cubic) { // Catmull-Rom
+		coefficients[1] = 0.5f * (p2 - p0);
+		coefficients[2] = p0 - 2.5f * p1 + 2.0f * p2 - 0.5f * p3;
+		coefficients[3] = 0.5f * (p3 - p0) + 1.5f * (p1 - p2);
+	}
+	else {
+		coefficients[1] = p2 - p1;
+		coefficients[2] = 0.0f;
+		coefficients[3] = 0.0f;
+	}
+
+	samplesUntilNextControlPoint = decimation;
+	step = 0;
+}
+
+//==============================================================================
+int WoflmakerModulationMatrix::addRoute(Source source, Target target, int scaleTarget) {
+	// a route can only be scaled by a target that is evaluated before its own
+	jassert(scaleTarget < (int)target);
+
+	routes.push_back({ source, target, scaleTarget, {} });
+	return (int)routes.size() - 1;
+}
+
+void WoflmakerModulationMatrix::prepare(double sampleRate, int maximumBlockSize) {
+	maxBlockSize = juce::jmax(1, maximumBlockSize);
+	rows = juce::dsp::AudioBlock<float>(rowMemory, (size_t)(numSources + numTargets + 1), (size_t)maxBlockSize);
+	rows.clear();
+
+	for (auto& base : bases)
+		base.reset(sampleRate, 0.02);
+	for (auto& route : routes)
+		route.amount.reset(sampleRate, 0.02);
+}
+
+bool WoflmakerModulationMatrix::isSourceActive(Source source) const noexcept {
+	for (auto& route : routes)
+		if (route.source == source && isActive(route.amount))
+			return true;
+	return false;
+}
+
+void WoflmakerModulationMatrix::process(int numSamples) noexcept {
+	jassert(numSamples <= maxBlockSize);
+	auto* scratch = rows.getChannelPointer((size_t)(numSources + numTargets));
+
+	for (int target = 0; target < numTargets; ++target) {
+		auto* row = rows.getChannelPointer((size_t)(numSources + target));
+		auto& base = bases[target];
+
+		if (base.isSmoothing()) {
+			for (int i = 0; i < numSamples; ++i)
+				row[i] = base.getNextValue();
+		}
+		else {
+			juce::FloatVectorOperations::fill(row, base.getTargetValue(), numSamples);
+		}
+
+		for (auto& route : routes) {
+			if (route.target != target || !isActive(route.amount))
+				continue;
+
+			const float* source = rows.getChannelPointer((size_t)route.source);
+			if (route.scaleTarget >= 0) {
+				juce::FloatVectorOperations::multiply(scratch, source, rows.getChannelPointer((size_t)(numSources + route.scaleTarget)), numSamples);
+				source = scratch;
+			}
+
+			if (route.amount.isSmoothing()) {
+				for (int i = 0; i < numSamples; ++i)
+					row[i] += source[i] * route.amount.getNextValue();
+			}
+			else {
+				juce::FloatVectorOperations::addWithMultiply(row, source, route.amount.getTargetValue(), numSamples);
+			}
+		}
+	}
+}
@@ -0,0 +1,104 @@
+#ifndef WOFLMAKERMODULATION_H
+#define WOFLMAKERMODULATION_H
+
+#include <JuceHeader.h>
+#include "WoflmakerLFOWavetables.h"
+
+/* A wavetable LFO that is only evaluated at a decimated control rate (once every decimationFactor samples) and interpolated back up to audio rate.
+The decimation factor trades CPU for modulation resolution: the table read costs 1/decimationFactor of an audio-rate one, while the output
+stays smooth because every sample is interpolated (linearly or with a Catmull-Rom cubic) between control points.
+Interpolating between the two middle points of a 4-point history means the output lags the oscillator by two control periods in either mode */
+class WoflmakerControlRateLFO {
+public:
+	enum class Interpolation { linear, cubic };
+
+	/* call from prepareToPlay(). decimationFactor = 1 reads the table every sample */
+	void prepare(double sampleRate, int decimationFactor);
+	void reset() noexcept;
+
+	void setFrequency(float newFrequencyHz) noexcept { frequency.setTargetValue(newFrequencyHz); }
+	void setInterpolation(Interpolation newInterpolation) noexcept { interpolation = newInterpolation; }
+
+	/* one of WoflmakerLFOWavetableBank::Shape. Safe to call from any thread; the audio thread picks it up at the next control point */
+	void setShape(int newShape) noexcept { shape = juce::jlimit(0, NUM_LFO_FUNCTIONS - 1, newShape); }
+	int getDecimationFactor() const noexcept { return decimation; }
+
+	/* table phase in the range {0.0, 1.0}, for saving with the plugin state. Both are safe to call from any thread:
+	the phase is published once per control point, and a new phase is picked up by the audio thread at the next process() call */
+	float getPhase() const noexcept { return publishedPhase.load(std::memory_order_relaxed); }
+	void setPhase(float newPhase) noexcept { requestedPhase.store(newPhase - std::floor(newPhase), std::memory_order_relaxed); }
+
+	/* writes numSamples of interpolated, audio-rate output in the range {-1.0, 1.0} */
+	void process(float* destination, int numSamples) noexcept;
+
+private:
+	juce::SharedResourcePointer<WoflmakerLFOWavetableBank> wavetables;
+	std::atomic<int> shape{ WoflmakerLFOWavetableBank::sine };
+	Interpolation interpolation = Interpolation::linear;
+
+	juce::LinearSmoothedValue<float> frequency; // advanced once per control point
+	float phase = 0.0f;
+	float controlRate = 44100.0f;
+	std::atomic<float> publishedPhase{ 0.0f }, requestedPhase{ -1.0f }; // requestedPhase < 0 means no request
+
+	int decimation = 1;
+	int samplesUntilNextControlPoint = 0;
+	float inverseDecimation = 1.0f;
+	int step = 0;
+
+	float controlPoints[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float coefficients[4] = { 0.0f, 0.0f, 0.0f, 0.0f }; // cubic in t between controlPoints[1] and controlPoints[2], lowest order first
+
+	void advanceControlPoint() noexcept;
+};
+
+/* Routes modulation sources (the LFOs) onto modulation targets (pan center, pan width). Every source and target is one contiguous row of
+samples (struct-of-arrays), and the whole matrix is evaluated once per processed sub-block: each target row is filled with its base value
+and every route into it adds one vectorised (source * amount) pass. Adding a target or a route costs one more pass, not another branch per sample.
+Targets are evaluated in enum order, so a route may be scaled by a target that comes before its own (pan width scales the pan center LFO) */
+class WoflmakerModulationMatrix {
+public:
+	enum Source { panCenterLFOSource = 0, panWidthLFOSource, numSources };
+	enum Target { panWidthTarget = 0, panCenterTarget, numTargets };
+
+	/* set up routes before prepare(); returns the index to pass to setRouteAmount(). scaleTarget = -1 for no scaling */
+	int addRoute(Source source, Target target, int scaleTarget = -1);
+
+	/* allocates the rows. Call from prepareToPlay() */
+	void prepare(double sampleRate, int maximumBlockSize);
+	int getMaximumBlockSize() const noexcept { return maxBlockSize; }
+
+	/* base values and route amounts are smoothed, so they can be set once per block from parameter values */
+	void setBase(Target target, float value) noexcept { bases[target].setTargetValue(value); }
+	void setRouteAmount(int route, float amount) noexcept { routes[(size_t)route].amount.setTargetValue(amount); }
+
+	/* false when every route out of this source has (and is settled at) zero amount, so the source doesn't need to be rendered */
+	bool isSourceActive(Source source) const noexcept;
+
+	/* row to render a source into before calling process() */
+	float* getSourceRow(Source source) noexcept { return rows.getChannelPointer((size_t)source); }
+	const float* getTargetRow(Target target) const noexcept { return rows.getChannelPointer((size_t)(numSources + target)); }
+
+	/* evaluates every target for numSamples samples (at most getMaximumBlockSize()) */
+	void process(int numSamples) noexcept;
+
+private:
+	struct Route {
+		Source source;
+		Target target;
+		int scaleTarget;
+		juce::LinearSmoothedValue<float> amount;
+	};
+
+	std::vector<Route> routes; // fixed once prepared
+	juce::LinearSmoothedValue<float> bases[numTargets];
+
+	// numSources source rows, then numTargets target rows, then one scratch row
+	juce::HeapBlock<char> rowMemory;
+	juce::dsp::AudioBlock<float> rows;
+	int maxBlockSize = 0;
+
+	static bool isActive(const juce::LinearSmoothedValue<float>& value) noexcept { return value.isSmoothing() || value.getTargetValue() != 0.0f; }
+};
+
+#endif
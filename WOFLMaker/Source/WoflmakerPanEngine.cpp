@@ -0,0 +1,59 @@
+#include "WoflmakerPanEngine.h"
+
+namespace {
+	/* cos/sin of (pi/4 + phi), phi = pan * pi/4, using cos(pi/4 + phi) = (cos(phi) - sin(phi)) / sqrt(2) and sin(pi/4 + phi) = (cos(phi) + sin(phi)) / sqrt(2).
+	Over phi in {-pi/4, pi/4} the truncated Taylor series below stay within 3e-7 of std::cos/std::sin.
+	Written only with (register * scalar), (register + scalar) and (register * register) so it works for both float and SIMDRegister<float> */
+	template <typename T>
+	inline void constantPowerGains(T pan, T& gainL, T& gainR) noexcept {
+		const T phi = pan * (juce::MathConstants<float>::pi * 0.25f);
+		const T phi2 = phi * phi;
+		const T s = phi * (((phi2 * (-1.0f / 5040.0f) + (1.0f / 120.0f)) * phi2 + (-1.0f / 6.0f)) * phi2 + 1.0f);
+		const T c = (((phi2 * (1.0f / 40320.0f) + (-1.0f / 720.0f)) * phi2 + (1.0f / 24.0f)) * phi2 + (-0.5f)) * phi2 + 1.0f;
+		gainL = (c - s) * (juce::MathConstants<float>::sqrt2 * 0.5f);
+		gainR = (c + s) * (juce::MathConstants<float>::sqrt2 * 0.5f);
+	}
+}
+
+void WoflmakerPanEngine::prepare(int maximumBlockSize) {
+	maxBlockSize = juce::jmax(1, maximumBlockSize);
+	// AudioBlock aligns every channel to sizeof(SIMDRegister<float>)
+	scratch = juce::dsp::AudioBlock<float>(scratchMemory, numScratchChannels, (size_t)maxBlockSize);
+	scratch.clear();
+}
+
+void WoflmakerPanEngine::process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept {
+	jassert(numSamples <= maxBlockSize);
+
+	auto* gainL = scratch.getChannelPointer(gainLChannel);
+	auto* gainR = scratch.getChannelPointer(gainRChannel);
+	computeGains(scratch.getChannelPointer(panChannel), gainL, gainR, numSamples);
+
+	juce::FloatVectorOperations::multiply(buffer.getWritePointer(0, startSample), gainL, numSamples);
+	if (buffer.getNumChannels() > 1)
+		juce::FloatVectorOperations::multiply(buffer.getWritePointer(1, startSample), gainR, numSamples);
+}
+
+void WoflmakerPanEngine::computeGains(const float* pan, float* gainL, float* gainR, int numSamples) noexcept {
+	using Register = juce::dsp::SIMDRegister<float>;
+	constexpr int lanes = (int)Register::SIMDNumElements;
+
+	jassert(Register::isSIMDAligned(pan) && Register::isSIMDAligned(gainL) && Register::isSIMDAligned(gainR));
+
+	const auto lower = Register::expand(-1.0f);
+	const auto upper = Register::expand(1.0f);
+
+	int i = 0;
+	for (; i + lanes <= numSamples; i += lanes) {
+		// pan can leave {-1.0, 1.0} when center + LFO * width overshoots. Clamp so both gains stay positive
+		auto p = Register::min(Register::max(Register::fromRawArray(pan + i), lower), upper);
+		Register l, r;
+		constantPowerGains(p, l, r);
+		l.copyToRawArray(gainL + i);
+		r.copyToRawArray(gainR + i);
+	}
+
+	// remainder
+	for (; i < numSamples; ++i)
+		constantPowerGains(juce::jlimit(-1.0f, 1.0f, pan[i]), gainL[i], gainR[i]);
+}
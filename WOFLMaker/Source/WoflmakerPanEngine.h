@@ -0,0 +1,34 @@
+#ifndef WOFLMAKERPANENGINE_H
+#define WOFLMAKERPANENGINE_H
+
+#include <JuceHeader.h>
+
+/* Constant-power pan law applied per sample. The processor writes a pan trajectory (one value per sample, in the range {-1.0, 1.0})
+into getPanTrajectory(), then process() converts it to left/right gains and applies them to the buffer. The cos/sin pair is evaluated
+with a polynomial approximation on juce::dsp::SIMDRegister lanes, so the cost stays below one std::cos/std::sin per sample */
+class WoflmakerPanEngine {
+public:
+	/* allocates the scratch buffers. Call from prepareToPlay(), never from the audio thread */
+	void prepare(int maximumBlockSize);
+
+	/* the largest number of samples that can be handled by one call to process() */
+	int getMaximumBlockSize() const noexcept { return maxBlockSize; }
+
+	/* pan values for the next call to process(); holds getMaximumBlockSize() floats */
+	float* getPanTrajectory() noexcept { return scratch.getChannelPointer(panChannel); }
+
+	/* applies the trajectory to numSamples samples of the buffer, starting at startSample. Channel 0 is left, channel 1 (if present) is right */
+	void process(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) noexcept;
+
+	/* constant-power gains for a block of pan values. pan, gainL and gainR must be aligned to juce::dsp::SIMDRegister<float> */
+	static void computeGains(const float* pan, float* gainL, float* gainR, int numSamples) noexcept;
+
+private:
+	enum { panChannel = 0, gainLChannel, gainRChannel, numScratchChannels };
+
+	juce::HeapBlock<char> scratchMemory;
+	juce::dsp::AudioBlock<float> scratch;
+	int maxBlockSize = 0;
+};
+
+#endif
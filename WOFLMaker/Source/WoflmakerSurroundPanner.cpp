@@ -0,0 +1,185 @@
+#include "WoflmakerSurroundPanner.h"
+
+float WoflmakerSurroundPanner::getAzimuth(juce::AudioChannelSet::ChannelType type) {
+	using CS = juce::AudioChannelSet;
+	switch (type) {
+	case CS::centre:				return 0.0f;
+	case CS::leftCentre:			return -15.0f;
+	case CS::rightCentre:			return 15.0f;
+	case CS::left:					return -30.0f;
+	case CS::right:					return 30.0f;
+	case CS::wideLeft:				return -60.0f;
+	case CS::wideRight:				return 60.0f;
+	case CS::leftSurroundSide:		return -90.0f;
+	case CS::rightSurroundSide:		return 90.0f;
+	case CS::leftSurround:			return -110.0f;
+	case CS::rightSurround:			return 110.0f;
+	case CS::leftSurroundRear:		return -150.0f;
+	case CS::rightSurroundRear:		return 150.0f;
+	case CS::centreSurround:
+	case CS::surround:				return 180.0f;
+	default:						return std::numeric_limits<float>::quiet_NaN();
+	}
+}
+
+float WoflmakerSurroundPanner::getAmbisonicGain(int acn, float azimuth) {
+	auto l = (int)std::sqrt((float)acn);
+	auto m = acn - l * l - l;
+	auto absM = std::abs(m);
+
+	// associated Legendre P(l, |m|) at x = 0, without the Condon-Shortley phase: P(m, m) = (2m - 1)!!, P(m + 1, m) = 0, then the
+	// recurrence (l - m) P(l, m) = (2l - 1) x P(l - 1, m) - (l + m - 1) P(l - 2, m)
+	double previous = 0.0, legendre = 1.0;
+	for (int k = 1; k <= absM; ++k)
+		legendre *= 2.0 * k - 1.0;
+	for (int k = absM + 1; k <= l; ++k) {
+		auto next = -(double)(k + absM - 1) * previous / (double)(k - absM);
+		previous = legendre;
+		legendre = next;
+	}
+
+	// SN3D: sqrt((2 - delta(m)) (l - |m|)! / (l + |m|)!)
+	double normalisation = absM == 0 ? 1.0 : 2.0;
+	for (int k = l - absM + 1; k <= l + absM; ++k)
+		normalisation /= (double)k;
+
+	auto angle = (double)absM * (double)azimuth * juce::MathConstants<double>::pi / 180.0;
+	return (float)(std::sqrt(normalisation) * legendre * (m < 0 ? std::sin(angle) : std::cos(angle)));
+}
+
+bool WoflmakerSurroundPanner::isLayoutSupported(const juce::AudioChannelSet& layout) {
+	if (layout.getAmbisonicOrder() >= 1)
+		return true;
+	if (layout.isDiscreteLayout())
+		return layout.size() >= 3;
+
+	int numSpeakers = 0;
+	for (auto type : layout.getChannelTypes()) {
+		if (type == juce::AudioChannelSet::LFE || type == juce::AudioChannelSet::LFE2)
+			continue;
+		if (std::isnan(getAzimuth(type)))
+			return false;
+		++numSpeakers;
+	}
+	return numSpeakers >= 3;
+}
+
+void WoflmakerSurroundPanner::prepare(const juce::AudioChannelSet& layout, int maximumBlockSize) {
+	jassert(isLayoutSupported(layout));
+	numChannels = layout.size();
+	maxBlockSize = juce::jmax(1, maximumBlockSize);
+	downmix.allocate((size_t)maxBlockSize, true);
+	tablePosition.allocate((size_t)maxBlockSize, true);
+	tableIndex.allocate((size_t)maxBlockSize, true);
+
+	speakerChannels.clearQuick();
+	downmixChannels.clearQuick();
+	speakerGainTables.clearQuick();
+
+	if (layout.getAmbisonicOrder() >= 1) {
+		// JUCE's ambisonic sets are in ACN order, so the channel index is the ACN
+		for (int channel = 0; channel < numChannels; ++channel)
+			speakerChannels.add(channel);
+		downmixChannels.add(0);
+		speakerGainTables.insertMultiple(0, 0.0f, numChannels * (tableResolution + 1));
+
+		for (int row = 0; row <= tableResolution; ++row) {
+			auto azimuth = 360.0f * (float)row / (float)tableResolution + 180.0f; // clockwise, as for speakers
+			for (int channel = 0; channel < numChannels; ++channel)
+				speakerGainTables.set(channel * (tableResolution + 1) + row, getAmbisonicGain(channel, -azimuth));
+		}
+		return;
+	}
+
+	// discrete layouts are treated as an evenly spaced ring starting straight ahead, which is also the usual ambisonic decoding rig
+	juce::Array<float> azimuths;
+	for (int channel = 0; channel < numChannels; ++channel) {
+		auto type = layout.getTypeOfChannel(channel);
+		if (type == juce::AudioChannelSet::LFE || type == juce::AudioChannelSet::LFE2)
+			continue;
+		auto azimuth = layout.isDiscreteLayout() ? 360.0f * (float)channel / (float)numChannels : getAzimuth(type);
+		speakerChannels.add(channel);
+		downmixChannels.add(channel);
+		azimuths.add(azimuth < 0.0f ? azimuth + 360.0f : azimuth);
+	}
+
+	// speaker indices in clockwise order, so every pan position falls between two neighbours
+	const auto numSpeakers = speakerChannels.size();
+	juce::Array<int> order;
+	for (int i = 0; i < numSpeakers; ++i)
+		order.add(i);
+	std::sort(order.begin(), order.end(), [&azimuths](int a, int b) { return azimuths[a] < azimuths[b]; });
+
+	speakerGainTables.insertMultiple(0, 0.0f, numSpeakers * (tableResolution + 1));
+
+	for (int row = 0; row <= tableResolution; ++row) {
+		// row 0 and the last row are both straight behind (pan -1.0 and 1.0)
+		auto azimuth = 360.0f * (float)row / (float)tableResolution + 180.0f;
+		azimuth -= 360.0f * std::floor(azimuth / 360.0f);
+
+		int pair = numSpeakers - 1; // the pair that wraps around from the last speaker to the first
+		for (int i = 0; i < numSpeakers - 1; ++i) {
+			if (azimuth >= azimuths[order[i]] && azimuth < azimuths[order[i + 1]]) {
+				pair = i;
+				break;
+			}
+		}
+		auto speakerA = order[pair], speakerB = order[(pair + 1) % numSpeakers];
+
+		/* 2D VBAP: solve p = gA * lA + gB * lB for the unit vectors of the pair, then normalise to constant power.
+		Pairs wider than 180 degrees can give a negative gain, which is clipped (the source then sits on the nearer speaker) */
+		auto toRadians = juce::MathConstants<float>::pi / 180.0f;
+		auto px = std::sin(azimuth * toRadians), py = std::cos(azimuth * toRadians);
+		auto ax = std::sin(azimuths[speakerA] * toRadians), ay = std::cos(azimuths[speakerA] * toRadians);
+		auto bx = std::sin(azimuths[speakerB] * toRadians), by = std::cos(azimuths[speakerB] * toRadians);
+		auto determinant = ax * by - ay * bx;
+
+		float gainA = 1.0f, gainB = 0.0f;
+		if (std::abs(determinant) > 1.0e-6f) {
+			gainA = juce::jmax(0.0f, (px * by - py * bx) / determinant);
+			gainB = juce::jmax(0.0f, (ax * py - ay * px) / determinant);
+		}
+		auto norm = std::sqrt(gainA * gainA + gainB * gainB);
+		if (norm > 0.0f) {
+			gainA /= norm;
+			gainB /= norm;
+		}
+
+		speakerGainTables.set(speakerA * (tableResolution + 1) + row, gainA);
+		speakerGainTables.set(speakerB * (tableResolution + 1) + row, gainB);
+	}
+}
+
+void WoflmakerSurroundPanner::process(juce::AudioBuffer<float>& buffer, const float* pan, int startSample, int numSamples) noexcept {
+	jassert(buffer.getNumChannels() >= numChannels);
+	jassert(numSamples <= maxBlockSize);
+
+	const auto numSpeakers = speakerChannels.size();
+	if (numSpeakers == 0)
+		return;
+
+	// equal-weight mono downmix of every speaker channel (LFE excluded), so a fully correlated input keeps its level; ambisonic input is
+	// only its W channel
+	juce::FloatVectorOperations::clear(downmix, numSamples);
+	for (auto channel : downmixChannels)
+		juce::FloatVectorOperations::add(downmix, buffer.getReadPointer(channel, startSample), numSamples);
+	juce::FloatVectorOperations::multiply(downmix, 1.0f / (float)downmixChannels.size(), numSamples);
+
+	// table positions are shared by every speaker, so they're only worked out once
+	for (int i = 0; i < numSamples; ++i) {
+		auto position = (juce::jlimit(-1.0f, 1.0f, pan[i]) + 1.0f) * 0.5f * (float)tableResolution;
+		auto index = juce::jmin((int)position, tableResolution - 1);
+		tableIndex[i] = index;
+		tablePosition[i] = position - (float)index;
+	}
+
+	for (int speaker = 0; speaker < numSpeakers; ++speaker) {
+		const auto* gains = speakerGainTables.getRawDataPointer() + speaker * (tableResolution + 1);
+		auto* output = buffer.getWritePointer(speakerChannels.getUnchecked(speaker), startSample);
+		for (int i = 0; i < numSamples; ++i) {
+			auto index = tableIndex[i];
+			auto gain = gains[index] + tablePosition[i] * (gains[index + 1] - gains[index]);
+			output[i] = downmix[i] * gain;
+		}
+	}
+}
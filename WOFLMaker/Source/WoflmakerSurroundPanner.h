@@ -0,0 +1,48 @@
+#ifndef WOFLMAKERSURROUNDPANNER_H
+#define WOFLMAKERSURROUNDPANNER_H
+
+#include <JuceHeader.h>
+
+/* Vector-base amplitude panning (VBAP) over a horizontal ring of speakers, for the layouts bigger than stereo (quad, 5.0/5.1, 7.0/7.1,
+discrete N-speaker rings...), and horizontal panning in ambisonic layouts.
+The non-LFE input channels are mixed down to mono and panned around the ring: pan -1.0 and 1.0 are straight behind the listener, 0.0 is
+straight ahead and positive values turn clockwise (to the right). LFE channels are left untouched.
+Ambisonic layouts (JUCE's ambisonic() sets, ACN order with SN3D normalisation) take their omnidirectional W channel as the mono source and
+encode it as a plane wave on the horizon at the pan angle; whatever direction the input soundfield had is replaced, as the downmix does
+for speakers.
+For every pan position the gains of the enclosing speaker pair (or the spherical harmonics) are solved once in prepare() and stored per
+channel in a table, so processing is only a table read and a multiply per channel per sample */
+class WoflmakerSurroundPanner {
+public:
+	/* true for layouts this panner can handle: ambisonic of order 1 or more, or at least 3 non-LFE speakers with known horizontal
+	positions */
+	static bool isLayoutSupported(const juce::AudioChannelSet& layout);
+
+	/* builds the speaker ring and gain tables for the layout and allocates the scratch buffers. Call from prepareToPlay() */
+	void prepare(const juce::AudioChannelSet& layout, int maximumBlockSize);
+
+	int getNumChannels() const noexcept { return numChannels; }
+
+	/* pans numSamples samples of the buffer, starting at startSample, following pan (one value per sample, in the range {-1.0, 1.0}) */
+	void process(juce::AudioBuffer<float>& buffer, const float* pan, int startSample, int numSamples) noexcept;
+
+private:
+	static constexpr int tableResolution = 720; // half a degree per table row
+
+	int numChannels = 0;
+	juce::Array<int> speakerChannels; // buffer channel of every non-LFE speaker, or of every ambisonic component
+	juce::Array<int> downmixChannels; // the channels summed into the mono source: the speakers, or only W
+	juce::Array<float> speakerGainTables; // one row of (tableResolution + 1) gains per speaker, in speakerChannels order
+
+	juce::HeapBlock<float> downmix, tablePosition;
+	juce::HeapBlock<int> tableIndex;
+	int maxBlockSize = 0;
+
+	/* azimuth in degrees (0 = front, positive = clockwise), or NaN for channels that aren't horizontal speakers */
+	static float getAzimuth(juce::AudioChannelSet::ChannelType type);
+
+	/* SN3D real spherical harmonic for ACN channel acn at elevation 0, azimuth in degrees counterclockwise as ambisonics counts it */
+	static float getAmbisonicGain(int acn, float azimuth);
+};
+
+#endif